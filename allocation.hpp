@@ -0,0 +1,114 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+// Per-level allocation policies used by BasicOrderBook::match.
+//
+// allocate(level, qty, on_fill) splits an incoming quantity across the resting
+// orders of one price level and returns whatever is left unfilled. For every
+// allocation the policy first decrements resting.qty and then calls
+// on_fill(resting, fill_qty); fully filled orders are removed from the level
+// after their callback has run.
+//
+// Level is a FIFO queue of orders: empty(), size(), front(), pop_front(),
+// forward iteration in time priority, and remove_filled() to unlink every
+// order whose qty reached zero.
+
+// Strict price-time priority: the oldest order at the level fills first.
+struct FifoAllocation {
+    template <class Level, class OnFill>
+    int allocate(Level& level, int qty, OnFill&& on_fill) {
+        while (qty > 0 && !level.empty()) {
+            auto& resting = level.front();
+            int fill = std::min(qty, resting.qty);
+            resting.qty -= fill;
+            qty -= fill;
+            on_fill(resting, fill);
+            if (resting.qty == 0) level.pop_front();  // O(1) intrusive unlink
+        }
+        return qty;
+    }
+};
+
+// Pro-rata: each resting order receives floor(qty * order_qty / level_qty),
+// and the rounding remainder is handed out one lot at a time in FIFO order.
+// Quantities are gathered into contiguous scratch arrays so the allocation
+// itself is a single branch-free pass the compiler can vectorize.
+class ProRataAllocation {
+    std::vector<int> qtys;
+    std::vector<int> fills;
+
+public:
+    template <class Level, class OnFill>
+    int allocate(Level& level, int qty, OnFill&& on_fill) {
+        const size_t n = level.size();
+        if (qty <= 0 || n == 0) return qty;
+
+        qtys.resize(n);
+        fills.resize(n);
+        int64_t total = 0;
+        size_t i = 0;
+        for (const auto& resting : level) {
+            qtys[i++] = resting.qty;
+            total += resting.qty;
+        }
+
+        // Incoming covers the whole level: everyone fills completely
+        if (total <= qty) {
+            std::copy(qtys.begin(), qtys.end(), fills.begin());
+        } else {
+            const double ratio = static_cast<double>(qty) / static_cast<double>(total);
+            const int* q = qtys.data();
+            int* f = fills.data();
+            for (size_t k = 0; k < n; ++k) f[k] = static_cast<int>(q[k] * ratio);
+
+            int64_t assigned = 0;
+            for (size_t k = 0; k < n; ++k) assigned += f[k];
+            // Guard against floating-point round-up, then spread the remainder
+            for (size_t k = n; assigned > qty && k > 0; --k) {
+                int take = static_cast<int>(std::min<int64_t>(f[k - 1], assigned - qty));
+                f[k - 1] -= take;
+                assigned -= take;
+            }
+            int64_t left = qty - assigned;
+            while (left > 0) {
+                for (size_t k = 0; k < n && left > 0; ++k) {
+                    if (f[k] < q[k]) { ++f[k]; --left; }
+                }
+            }
+        }
+
+        int filled = 0;
+        i = 0;
+        for (auto& resting : level) {
+            int fill = fills[i++];
+            if (fill == 0) continue;
+            resting.qty -= fill;
+            filled += fill;
+            on_fill(resting, fill);
+        }
+        level.remove_filled();
+        return qty - filled;
+    }
+};
+
+// The order at the front of the level fills first, the rest of the incoming
+// quantity is shared pro-rata across the remaining orders.
+class TopOrderProRataAllocation {
+    ProRataAllocation pro_rata;
+
+public:
+    template <class Level, class OnFill>
+    int allocate(Level& level, int qty, OnFill&& on_fill) {
+        if (qty > 0 && !level.empty()) {
+            auto& top = level.front();
+            int fill = std::min(qty, top.qty);
+            top.qty -= fill;
+            qty -= fill;
+            on_fill(top, fill);
+            if (top.qty == 0) level.pop_front();
+        }
+        return qty > 0 ? pro_rata.allocate(level, qty, on_fill) : qty;
+    }
+};
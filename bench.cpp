@@ -0,0 +1,605 @@
+#include "command_log.hpp"
+#include "concurrent_book.hpp"
+#include "experiments/soa_level.hpp"
+#include "gateway.hpp"
+#include "histogram.hpp"
+#include "journal.hpp"
+#include "md_feed.hpp"
+#include "order_flow.hpp"
+#include "orderbook.hpp"
+#include "perf_counters.hpp"
+#include "protocol.hpp"
+#include "top_of_book.hpp"
+#include "trade_log.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <deque>
+#include <utility>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+volatile int64_t sink;
+
+template <class F>
+double ns_per_op(int reps, size_t ops_per_rep, F&& body) {
+    body();  // warm caches
+    auto start = Clock::now();
+    for (int r = 0; r < reps; ++r) body();
+    auto end = Clock::now();
+    double ns = static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count());
+    return ns / (static_cast<double>(reps) * static_cast<double>(ops_per_rep));
+}
+
+void report(const char* name, size_t n, double ns) {
+    std::cout << std::left << std::setw(28) << name << " n=" << std::setw(8) << n
+              << std::right << std::fixed << std::setprecision(3) << std::setw(9) << ns << " ns/order  "
+              << std::setprecision(1) << std::setw(8) << 1e3 / ns << " M orders/s\n";
+}
+
+// Level-wide aggregation and id search: std::deque<Order> vs SoA columns
+void bench_level_scan(size_t depth) {
+    std::deque<Order> aos;
+    SoaPriceLevel soa_level;
+    for (size_t i = 0; i < depth; ++i) {
+        Order o(i + 1, static_cast<int32_t>(1 + i % 97));
+        aos.push_back(o);
+        soa_level.push_back(o.id, o.qty, o.ts);
+    }
+    const int reps = static_cast<int>(20000000 / depth) + 1;
+    const uint64_t needle = depth;  // worst case: last order
+
+    report("level_sum/deque", depth, ns_per_op(reps, depth, [&] {
+        int64_t total = 0;
+        for (const auto& o : aos) total += o.qty;
+        sink = total;
+    }));
+    report("level_sum/soa_scalar", depth, ns_per_op(reps, depth, [&] {
+        sink = soa::sum_qty_scalar(soa_level.qty_data(), soa_level.size());
+    }));
+    report("level_sum/soa", depth, ns_per_op(reps, depth, [&] {
+        sink = soa_level.total_qty();
+    }));
+
+    report("level_find/deque", depth, ns_per_op(reps, depth, [&] {
+        int64_t pos = -1, i = 0;
+        for (const auto& o : aos) {
+            if (o.id == needle) { pos = i; break; }
+            ++i;
+        }
+        sink = pos;
+    }));
+    report("level_find/soa_scalar", depth, ns_per_op(reps, depth, [&] {
+        sink = soa::find_id_scalar(soa_level.id_data(), soa_level.size(), needle);
+    }));
+    report("level_find/soa", depth, ns_per_op(reps, depth, [&] {
+        sink = soa_level.find(needle);
+    }));
+}
+
+// Deep FIFO queue at one price swept by a single aggressive order
+void bench_deep_sweep(size_t depth) {
+    const int reps = 20;
+    double total_ns = 0;
+    for (int r = 0; r < reps; ++r) {
+        OrderBook ob;
+        for (size_t i = 0; i < depth; ++i) ob.add_limit(100.0, 1, false);
+        auto start = Clock::now();
+        ob.add_market(static_cast<int>(depth), true);
+        auto end = Clock::now();
+        total_ns += static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count());
+        sink = static_cast<int64_t>(ob.get_trades().size());
+    }
+    report("deep_sweep/match", depth, total_ns / (reps * static_cast<double>(depth)));
+}
+
+// queue_position() on one deep level: the first query indexes the level,
+// later ones walk a Fenwick tree
+void bench_queue_position(size_t depth) {
+    OrderBook ob;
+    for (size_t i = 0; i < depth; ++i) ob.add_limit(100.0, 1 + static_cast<int>(i % 9), false);
+    QueuePosition p;
+    auto start = Clock::now();
+    ob.queue_position(depth, p);
+    auto end = Clock::now();
+    const double build_us =
+        static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count()) / 1e3;
+    uint64_t x = 88172645463325252ULL;
+    int64_t acc = 0;
+    const double query = ns_per_op(5, 100000, [&] {
+        for (int i = 0; i < 100000; ++i) {
+            x ^= x << 13; x ^= x >> 7; x ^= x << 17;
+            ob.queue_position(1 + x % depth, p);
+            acc += p.qty_ahead;
+        }
+    });
+    sink = acc;
+    std::cout << "queue_position depth=" << std::setw(8) << std::left << depth << std::right << std::fixed
+              << " index " << std::setprecision(1) << std::setw(8) << build_us << " us, query "
+              << std::setprecision(1) << std::setw(6) << query << " ns\n";
+}
+
+// Cancel resting orders in a scattered order (index lookup + unlink)
+void bench_cancel(size_t n) {
+    OrderBook ob;
+    std::vector<uint64_t> ids;
+    ids.reserve(n);
+    for (size_t i = 0; i < n; ++i) {
+        ids.push_back(ob.add_limit(90.0 + static_cast<double>(i % 100) * 0.1, 10, true));
+    }
+    // Deterministic shuffle (LCG-driven Fisher-Yates)
+    uint64_t x = 88172645463325252ull;
+    for (size_t i = n - 1; i > 0; --i) {
+        x = x * 6364136223846793005ull + 1442695040888963407ull;
+        std::swap(ids[i], ids[(x >> 33) % (i + 1)]);
+    }
+    auto start = Clock::now();
+    for (uint64_t id : ids) ob.cancel(id);
+    auto end = Clock::now();
+    sink = static_cast<int64_t>(ob.total_orders());
+    report("cancel/scattered", n,
+           static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count()) / n);
+}
+
+// Binary order entry: decode + match + encode acks/fills, per message
+void bench_protocol(size_t n) {
+    OrderBook ob;
+    OrderEntrySession session(ob);
+    std::vector<uint8_t> in(n * proto::NEW_ORDER_SIZE);
+    size_t len = 0;
+    uint64_t id = 0;
+    for (size_t i = 0; i < n; ++i) {
+        // Mix of resting orders, crossing orders and cancels of recent ids
+        if (i % 4 == 3 && id > 2) {
+            len += proto::encode_cancel(in.data() + len, id - 2);
+        } else {
+            bool is_bid = i % 2 == 0;
+            double price = 100.0 + (is_bid ? -1.0 : 1.0) * static_cast<double>(i % 5) * 0.1;
+            len += proto::encode_new_order(in.data() + len, is_bid, price, 10, static_cast<uint32_t>(i % 8));
+            ++id;
+        }
+    }
+    auto start = Clock::now();
+    size_t pos = 0;
+    while (pos < len) {
+        size_t chunk = std::min<size_t>(len - pos, 4096);
+        pos += session.process(in.data() + pos, chunk);
+        session.clear_out();  // as if flushed to the socket
+    }
+    auto end = Clock::now();
+    sink = static_cast<int64_t>(ob.total_orders());
+    report("protocol/decode_match_encode", n,
+           static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count()) / n);
+}
+
+// Book events published over loopback multicast, flushed every `batch` commands
+void bench_md_feed(size_t n, size_t batch) {
+    MdPublisher pub;
+    if (!pub.open("239.255.0.1", 30999)) {
+        std::cout << "md_feed: multicast unavailable, skipped\n";
+        return;
+    }
+    OrderBook ob;
+    ob.add_listener(&pub);
+    auto start = Clock::now();
+    for (size_t i = 0; i < n; ++i) {
+        bool is_bid = i % 2 == 0;
+        double price = 100.0 + (is_bid ? -1.0 : 1.0) * static_cast<double>(i % 20) * 0.1;
+        ob.add_limit(price, 10, is_bid);
+        if (i % batch == batch - 1) pub.flush();
+    }
+    pub.flush();
+    auto end = Clock::now();
+    ob.remove_listener(&pub);
+    sink = static_cast<int64_t>(pub.datagrams_sent());
+    report(batch == 1 ? "md_feed/flush_every_order" : "md_feed/flush_every_256", n,
+           static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count()) / n);
+    std::cout << "  " << pub.datagrams_sent() << " datagrams, " << pub.send_calls() << " sendmmsg calls\n";
+}
+
+// Production-like mix from the seeded generator: mostly adds and cancels
+// near the touch, 30 cancels per trade over the run, occasional sweeps
+void bench_flow(size_t n) {
+    OrderFlowGenerator gen;
+    std::vector<FlowEvent> events(n);
+    for (auto& e : events) e = gen.next();
+
+    OrderBook ob;
+    LatencyHistogram latency;
+    auto start = Clock::now();
+    for (const auto& e : events) {
+        auto t0 = Clock::now();
+        apply_flow(ob, e);
+        latency.record(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - t0).count()));
+    }
+    auto end = Clock::now();
+    sink = static_cast<int64_t>(ob.total_orders());
+    report("flow/synthetic_mix", n,
+           static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count()) / n);
+    std::cout << "  " << gen.cancels() << " cancels, " << gen.trades() << " trades, "
+              << gen.sweeps() << " sweeps, " << ob.total_orders() << " resting\n";
+    latency.print(std::cout, "  per event");
+}
+
+// Generated flow with a seqlock top-of-book published after every event,
+// then the cost of a reader's consistent copy of each record
+void bench_top_of_book(size_t n) {
+    OrderFlowGenerator gen;
+    std::vector<FlowEvent> events(n);
+    for (auto& e : events) e = gen.next();
+
+    OrderBook ob;
+    auto top = std::make_unique<TopOfBook>();
+    ob.add_listener(top.get());
+    size_t published = 0;
+    auto start = Clock::now();
+    for (const auto& e : events) {
+        apply_flow(ob, e);
+        published += top->publish(ob);
+    }
+    auto end = Clock::now();
+    ob.remove_listener(top.get());
+    report("top_of_book/flow+publish", n,
+           static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count()) / n);
+    std::cout << "  " << published << " versions published (" << std::setprecision(1)
+              << 100.0 * static_cast<double>(published) / static_cast<double>(n) << "% of events)\n";
+
+    Touch t;
+    BookDepth d;
+    report("top_of_book/read_touch", 1, ns_per_op(1000000, 1, [&] {
+        top->touch(t);
+        sink = t.bid_qty;
+    }));
+    report("top_of_book/read_depth", 1, ns_per_op(1000000, 1, [&] {
+        top->depth(d);
+        sink = d.asks[0].qty;
+    }));
+}
+
+// Session threads submitting into the gateway while the matching thread
+// drains it. Submit cost is per-thread CPU time, so time slices lost to the
+// other threads are not counted; rings hold a whole run, so nobody waits.
+void bench_gateway(size_t sessions, size_t per_session) {
+    OrderGateway gw(sessions, per_session);
+    OrderBook ob;
+    std::atomic<bool> go{false};
+    std::vector<double> ns(sessions);
+    std::vector<std::thread> producers;
+    for (size_t s = 0; s < sessions; ++s) {
+        producers.emplace_back([&, s] {
+            uint8_t msg[proto::NEW_ORDER_SIZE];
+            while (!go.load(std::memory_order_acquire)) std::this_thread::yield();
+            timespec t0, t1;
+            clock_gettime(CLOCK_THREAD_CPUTIME_ID, &t0);
+            for (size_t i = 0; i < per_session; ++i) {
+                proto::encode_new_order(msg, true, 90.0 + static_cast<double>(i & 63) * 0.1, 10,
+                                        static_cast<uint32_t>(s));
+                gw.submit(s, msg);
+            }
+            clock_gettime(CLOCK_THREAD_CPUTIME_ID, &t1);
+            ns[s] = (static_cast<double>(t1.tv_sec - t0.tv_sec) * 1e9 + static_cast<double>(t1.tv_nsec - t0.tv_nsec)) /
+                    static_cast<double>(per_session);
+        });
+    }
+    const auto start = Clock::now();
+    go.store(true, std::memory_order_release);
+    size_t drained = 0;
+    while (drained < sessions * per_session) {
+        const size_t n = gw.drain(ob);
+        drained += n;
+        if (n == 0) std::this_thread::yield();
+    }
+    const auto end = Clock::now();
+    for (auto& t : producers) t.join();
+    sink = static_cast<int64_t>(ob.total_orders());
+
+    double worst = 0;
+    for (double v : ns) worst = std::max(worst, v);
+    const std::string name = "gateway/submit_" + std::to_string(sessions) + "_sessions";
+    report(name.c_str(), sessions * per_session, worst);
+    std::cout << "  end to end " << std::setprecision(1)
+              << static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count()) /
+                 static_cast<double>(drained)
+              << " ns/order including matching\n";
+}
+
+// Trade-heavy flow (2 cancels per trade) with and without the trade log
+// attached; the difference is what persistence costs the matching thread
+void bench_trade_log(size_t n) {
+    FlowConfig config;
+    config.cancel_to_trade = 2.0;
+    std::vector<FlowEvent> events(n);
+    OrderFlowGenerator gen(config);
+    for (auto& e : events) e = gen.next();
+
+    // 0: no log, 1: pwrite backend, 2: io_uring backend
+    for (int mode = 0; mode < 3; ++mode) {
+        const bool persist = mode != 0;
+        OrderBook ob;
+        tradelog::TradeLog log(mode == 2 ? journal::make_uring_backend() : journal::make_sync_backend());
+        if (persist) {
+            if (!log.open("/tmp/lob_bench_trades.bin")) {
+                std::cout << "trade_log: cannot open /tmp/lob_bench_trades.bin with " << log.backend_name()
+                          << ", skipped\n";
+                continue;
+            }
+            ob.add_listener(&log);
+        }
+        auto start = Clock::now();
+        for (const auto& e : events) apply_flow(ob, e);
+        auto end = Clock::now();
+        const char* names[] = {"trade_log/flow_only", "trade_log/flow+persist", "trade_log/flow+persist_uring"};
+        report(names[mode], n,
+               static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count()) / n);
+        if (persist) {
+            log.close();
+            const tradelog::Stats st = log.stats();
+            std::cout << "  " << st.records_written << " trades in " << st.write_calls << " writes, ring peak "
+                      << st.ring_peak << ", ring full " << st.ring_full << " times\n";
+            std::remove("/tmp/lob_bench_trades.bin");
+        }
+    }
+}
+
+// Trade-heavy flow with and without the retained trade history, then VWAP
+// by rescanning get_trades() versus the running total
+void bench_trade_analytics(size_t n) {
+    FlowConfig config;
+    config.cancel_to_trade = 2.0;
+    std::vector<FlowEvent> events(n);
+    OrderFlowGenerator gen(config);
+    for (auto& e : events) e = gen.next();
+
+    OrderBook retained, streaming;
+    streaming.set_retain_trades(false);
+    for (OrderBook* ob : {&retained, &streaming}) {
+        auto start = Clock::now();
+        for (const auto& e : events) apply_flow(*ob, e);
+        auto end = Clock::now();
+        report(ob == &retained ? "analytics/flow+history" : "analytics/flow_streaming", n,
+               static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count()) / n);
+    }
+
+    const size_t trades = retained.get_trades().size();
+    double v = 0.0;
+    const double rescan = ns_per_op(20, 1, [&] {
+        double notional = 0.0;
+        int64_t volume = 0;
+        for (const Trade& t : retained.get_trades()) {
+            notional += t.price * t.qty;
+            volume += t.qty;
+        }
+        v += volume ? notional / static_cast<double>(volume) : 0.0;
+    });
+    const double running = ns_per_op(20, 1000, [&] {
+        for (int i = 0; i < 1000; ++i) v += streaming.analytics().vwap();
+    });
+    sink = static_cast<int64_t>(v);
+    std::cout << "vwap over " << trades << " trades: rescan " << std::fixed << std::setprecision(0) << rescan
+              << " ns, running " << std::setprecision(2) << running << " ns; "
+              << streaming.analytics().bars().size() + 1 << " bars\n";
+}
+
+// Synthetic flow with the imbalance/microprice aggregates off and on
+void bench_book_signals(size_t n) {
+    std::vector<FlowEvent> events(n);
+    OrderFlowGenerator gen;
+    for (auto& e : events) e = gen.next();
+    for (size_t depth : {0, 1, 5, 10}) {
+        OrderBook ob;
+        ob.set_signal_depth(depth);
+        auto start = Clock::now();
+        for (const auto& e : events) apply_flow(ob, e);
+        auto end = Clock::now();
+        const std::string name = "signals/depth=" + std::to_string(depth);
+        report(name.c_str(), n,
+               static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count()) / n);
+        sink = static_cast<int64_t>(ob.signals().version);
+    }
+}
+
+// Durable commands per second: every command is journaled and counted only
+// once its group's data sync has completed
+void bench_journal(bool uring, size_t group, size_t commands) {
+    const char* path = "/tmp/lob_bench_journal.bin";
+    journal::Options options;
+    options.group_records = group;
+    journal::Journal j(uring ? journal::make_uring_backend() : journal::make_sync_backend(), options);
+    if (!j.open(path)) {
+        std::cout << "journal/" << (uring ? "io_uring" : "sync") << ": backend unavailable, skipped\n";
+        return;
+    }
+    OrderBook ob;
+    uint8_t msg[proto::NEW_ORDER_SIZE];
+    auto start = Clock::now();
+    for (size_t i = 0; i < commands; ++i) {
+        const bool is_bid = i % 2 == 0;
+        proto::encode_new_order(msg, is_bid, 100.0 + (is_bid ? -0.1 : 0.1) * static_cast<double>(1 + i % 8), 10, 0);
+        j.append(static_cast<int64_t>(i), msg);
+        cmdlog::apply(ob, msg);
+    }
+    j.sync();
+    auto end = Clock::now();
+    const double secs = static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count()) / 1e9;
+    std::cout << std::left << std::setw(16) << j.backend_name() << " group=" << std::setw(5) << group << std::right
+              << std::fixed << std::setprecision(0) << std::setw(10) << static_cast<double>(j.durable()) / secs
+              << " durable cmds/s  " << std::setprecision(1) << std::setw(8)
+              << secs * 1e6 / static_cast<double>(j.groups()) << " us/group\n";
+    j.close();
+    std::remove(path);
+}
+
+// OrderBook behind one mutex, the baseline for ConcurrentOrderBook
+struct MutexOrderBook {
+    std::mutex mu;
+    OrderBook book;
+    uint64_t add_limit(double price, int qty, bool is_bid) {
+        std::lock_guard<std::mutex> g(mu);
+        return book.add_limit(price, qty, is_bid);
+    }
+    uint64_t add_market(int qty, bool is_bid) {
+        std::lock_guard<std::mutex> g(mu);
+        return book.add_market(qty, is_bid);
+    }
+    bool cancel(uint64_t id) {
+        std::lock_guard<std::mutex> g(mu);
+        return book.cancel(id);
+    }
+};
+
+// Each thread keeps up to 64 resting orders on its own side and price band,
+// cancelling the oldest to add a new one; 1 command in 100 is a market order
+template <class Book>
+double threaded_mix(Book& book, size_t threads, size_t per_thread) {
+    std::atomic<bool> go{false};
+    std::vector<std::thread> pool;
+    for (size_t w = 0; w < threads; ++w) {
+        pool.emplace_back([&, w] {
+            const bool is_bid = w % 2 == 0;
+            const double base = is_bid ? 99.0 - 0.25 * static_cast<double>(w / 2 % 8) * 4
+                                       : 101.0 + 0.25 * static_cast<double>(w / 2 % 8) * 4;
+            std::deque<uint64_t> mine;
+            while (!go.load(std::memory_order_acquire)) std::this_thread::yield();
+            for (size_t i = 0; i < per_thread; ++i) {
+                if (i % 100 == 99) {
+                    book.add_market(1, !is_bid);
+                } else if (mine.size() >= 64) {
+                    book.cancel(mine.front());
+                    mine.pop_front();
+                } else {
+                    const double offset = 0.25 * static_cast<double>(i % 4);
+                    mine.push_back(book.add_limit(is_bid ? base - offset : base + offset, 10, is_bid));
+                }
+            }
+        });
+    }
+    const auto start = Clock::now();
+    go.store(true, std::memory_order_release);
+    for (auto& t : pool) t.join();
+    const auto end = Clock::now();
+    return static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count()) /
+           static_cast<double>(threads * per_thread);
+}
+
+void bench_concurrent_book(size_t threads) {
+    const size_t per_thread = 400000 / threads;
+    MutexOrderBook locked;
+    const std::string mutex_name = "mutex_book/" + std::to_string(threads) + "_threads";
+    report(mutex_name.c_str(), threads * per_thread, threaded_mix(locked, threads, per_thread));
+    ConcurrentOrderBook concurrent(80.0, 0.25, 160, threads * per_thread + 1);
+    const std::string name = "concurrent_book/" + std::to_string(threads) + "_threads";
+    report(name.c_str(), threads * per_thread, threaded_mix(concurrent, threads, per_thread));
+}
+
+// Hardware counters around each phase of the book's life: resting adds,
+// scattered cancels and small market orders matching against depth
+void profile_phases(size_t n) {
+    PerfCounters pmu;
+    if (!pmu.open()) {
+        std::cout << "hardware counters unavailable: " << pmu.error() << "\n";
+        return;
+    }
+    const unsigned present = pmu.present();
+    CounterSample sample;
+    const auto phase = [&](const char* name, size_t ops, auto&& body) {
+        pmu.enable();
+        body();
+        pmu.disable();
+        pmu.read(sample);
+        CounterTotals totals;
+        totals.add(sample, ops);
+        totals.print(std::cout, name, present);
+    };
+
+    OrderBook ob;
+    std::vector<uint64_t> ids(n);
+    phase("add_limit", n, [&] {
+        for (size_t i = 0; i < n; ++i) {
+            ids[i] = ob.add_limit(90.0 + static_cast<double>(i % 200) * 0.05, 10, true);
+        }
+    });
+    uint64_t x = 88172645463325252ull;
+    for (size_t i = n - 1; i > 0; --i) {
+        x = x * 6364136223846793005ull + 1442695040888963407ull;
+        std::swap(ids[i], ids[(x >> 33) % (i + 1)]);
+    }
+    phase("cancel", n, [&] {
+        for (uint64_t id : ids) ob.cancel(id);
+    });
+
+    for (size_t i = 0; i < n; ++i) ob.add_limit(100.0 + static_cast<double>(i % 100) * 0.01, 10, false);
+    phase("match", n, [&] {
+        for (size_t i = 0; i < n; ++i) ob.add_market(10, true);
+    });
+    sink = static_cast<int64_t>(ob.get_trades().size());
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    if (argc > 1 && std::strcmp(argv[1], "--counters") == 0) {
+        std::cout << "--- Hardware Counters (per op) ---" << std::endl;
+        profile_phases(1000000);
+        return 0;
+    }
+
+    std::cout << "=====================================" << std::endl;
+    std::cout << "  Order Book Benchmarks" << std::endl;
+    std::cout << "=====================================" << std::endl;
+    std::cout << "AVX2: " << (soa::has_avx2() ? "yes" : "no") << "\n";
+    std::cout << "sizeof(Order): " << sizeof(Order) << " bytes\n";
+
+    std::cout << "\n--- Synthetic Order Flow ---" << std::endl;
+    bench_flow(2000000);
+
+    std::cout << "\n--- Top of Book Snapshot ---" << std::endl;
+    bench_top_of_book(1000000);
+
+    std::cout << "\n--- Trade Persistence ---" << std::endl;
+    bench_trade_log(1000000);
+
+    std::cout << "\n--- Streaming Trade Analytics ---" << std::endl;
+    bench_trade_analytics(1000000);
+
+    std::cout << "\n--- Imbalance and Microprice Signals ---" << std::endl;
+    bench_book_signals(1000000);
+
+    std::cout << "\n--- Durable Journal (/tmp) ---" << std::endl;
+    for (bool uring : {false, true}) {
+        for (size_t group : {1, 16, 256}) bench_journal(uring, group, group == 1 ? 2000 : 200 * group);
+    }
+
+    std::cout << "\n--- Gateway Intake ---" << std::endl;
+    for (size_t sessions : {1, 4, 16}) bench_gateway(sessions, 100000);
+
+    std::cout << "\n--- Concurrent Book (" << std::thread::hardware_concurrency() << " hardware threads) ---" << std::endl;
+    for (size_t threads : {1, 2, 4, 8, 16}) bench_concurrent_book(threads);
+
+    std::cout << "\n--- Level Scan ---" << std::endl;
+    for (size_t depth : {64, 1024, 16384}) bench_level_scan(depth);
+
+    std::cout << "\n--- Deep Queue Sweep ---" << std::endl;
+    for (size_t depth : {1000, 100000, 1000000}) bench_deep_sweep(depth);
+
+    std::cout << "\n--- Queue Position ---" << std::endl;
+    for (size_t depth : {100, 10000, 1000000}) bench_queue_position(depth);
+
+    std::cout << "\n--- Cancel ---" << std::endl;
+    for (size_t n : {10000, 1000000}) bench_cancel(n);
+
+    std::cout << "\n--- Binary Order Entry ---" << std::endl;
+    bench_protocol(1000000);
+
+    std::cout << "\n--- Market Data Publish ---" << std::endl;
+    for (size_t batch : {1, 256}) bench_md_feed(1000000, batch);
+
+    return 0;
+}
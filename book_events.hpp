@@ -0,0 +1,22 @@
+#pragma once
+#include <cstdint>
+
+struct Trade;
+
+// Aggregate state of one price level
+struct LevelInfo {
+    double price = 0.0;
+    int64_t qty = 0;      // 0 when the level has just been removed
+    uint32_t count = 0;   // resting orders
+};
+
+// Observer for book changes, called synchronously on the matching thread.
+// on_level reports the level's new aggregate after every change to it
+// (insert, fill, cancel, modify); qty == 0 means the level is gone.
+// clear() is not reported.
+class BookListener {
+public:
+    virtual ~BookListener() = default;
+    virtual void on_trade(const Trade& trade) { (void)trade; }
+    virtual void on_level(bool is_bid, const LevelInfo& level) { (void)is_bid; (void)level; }
+};
@@ -0,0 +1,227 @@
+#include "command_log.hpp"
+#include "protocol.hpp"
+#include <chrono>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+
+namespace cmdlog {
+
+using proto::load;
+using proto::store;
+using Clock = std::chrono::steady_clock;
+
+// ---------------- Writer ----------------
+
+Writer::Writer(size_t buffer_size) : buf(buffer_size) {}
+
+Writer::~Writer() { close(); }
+
+bool Writer::open(const std::string& path) {
+    close();
+    fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    failed = fd < 0;
+    count = 0;
+    len = 0;
+    if (failed) return false;
+    std::memcpy(buf.data(), MAGIC, sizeof(MAGIC));
+    store<uint64_t>(buf.data() + 8, 0);
+    len = FILE_HEADER_SIZE;
+    return true;
+}
+
+void Writer::write_all(const uint8_t* p, size_t n) {
+    size_t done = 0;
+    while (done < n && !failed) {
+        ssize_t r = ::write(fd, p + done, n - done);
+        if (r < 0) failed = true;
+        else done += static_cast<size_t>(r);
+    }
+}
+
+void Writer::drain() {
+    write_all(buf.data(), len);
+    len = 0;
+}
+
+void Writer::append(int64_t ts_ns, const uint8_t* msg) {
+    if (fd < 0) return;
+    const size_t n = RECORD_HEADER_SIZE + proto::msg_length(msg);
+    if (len + n > buf.size()) drain();
+    store<int64_t>(buf.data() + len, ts_ns);
+    std::memcpy(buf.data() + len + RECORD_HEADER_SIZE, msg, n - RECORD_HEADER_SIZE);
+    len += n;
+    ++count;
+}
+
+void Writer::append_records(const uint8_t* records, size_t n_bytes, uint64_t n_records) {
+    if (fd < 0) return;
+    if (len + n_bytes > buf.size()) drain();
+    if (n_bytes > buf.size()) {
+        write_all(records, n_bytes);  // large batches skip the buffer
+    } else {
+        std::memcpy(buf.data() + len, records, n_bytes);
+        len += n_bytes;
+    }
+    count += n_records;
+}
+
+bool Writer::close() {
+    if (fd < 0) return !failed;
+    drain();
+    uint8_t n[8];
+    store<uint64_t>(n, count);
+    if (::pwrite(fd, n, sizeof(n), 8) != static_cast<ssize_t>(sizeof(n))) failed = true;
+    if (::close(fd) != 0) failed = true;
+    fd = -1;
+    return !failed;
+}
+
+// ---------------- MappedFile ----------------
+
+MappedFile::~MappedFile() { close(); }
+
+bool MappedFile::open(const std::string& path) {
+    close();
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0) {
+        ::close(fd);
+        return false;
+    }
+    void* p = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE | MAP_POPULATE, fd, 0);
+    ::close(fd);  // the mapping keeps the file alive
+    if (p == MAP_FAILED) return false;
+    madvise(p, static_cast<size_t>(st.st_size), MADV_SEQUENTIAL);
+    base = static_cast<const uint8_t*>(p);
+    length = static_cast<size_t>(st.st_size);
+    return true;
+}
+
+void MappedFile::close() {
+    if (base) munmap(const_cast<uint8_t*>(base), length);
+    base = nullptr;
+    length = 0;
+}
+
+// ---------------- Reader ----------------
+
+Reader::Reader(const uint8_t* d, size_t n) : data(d), len(n) {
+    ok = len >= FILE_HEADER_SIZE && std::memcmp(data, MAGIC, sizeof(MAGIC)) == 0;
+    if (ok) declared = load<uint64_t>(data + 8);
+}
+
+bool Reader::next(int64_t& ts_ns, const uint8_t*& msg) {
+    if (!ok || len - pos < RECORD_HEADER_SIZE + proto::HEADER_SIZE) return false;
+    const uint8_t* rec = data + pos;
+    const size_t length = proto::msg_length(rec + RECORD_HEADER_SIZE);
+    if (length < proto::HEADER_SIZE || len - pos - RECORD_HEADER_SIZE < length) return false;
+    ts_ns = load<int64_t>(rec);
+    msg = rec + RECORD_HEADER_SIZE;
+    pos += RECORD_HEADER_SIZE + length;
+    return true;
+}
+
+// ---------------- replay ----------------
+
+bool apply(OrderBook& book, const uint8_t* msg) { return proto::apply(book, msg).accepted; }
+
+namespace {
+
+// apply() between two group reads, charged to the command's kind. Expiries
+// run by advance_time() beforehand are not included.
+void counted_apply(OrderBook& book, const uint8_t* msg, const PerfCounters& pmu,
+                   ReplayStats& stats, bool latency) {
+    const uint64_t trades_before = book.analytics().trades();
+    CounterSample before, after;
+    pmu.read(before);
+    const auto t0 = Clock::now();
+    const bool accepted = apply(book, msg);
+    const auto t1 = Clock::now();
+    pmu.read(after);
+    if (latency) {
+        stats.latency.record(static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0).count()));
+    }
+    if (!accepted) ++stats.rejected;
+
+    const CounterSample delta = after - before;
+    switch (proto::msg_type(msg)) {
+        case proto::MsgType::NewOrder:
+            (book.analytics().trades() != trades_before ? stats.match_counters : stats.add_counters).add(delta);
+            break;
+        case proto::MsgType::Market: stats.match_counters.add(delta); break;
+        case proto::MsgType::Cancel: stats.cancel_counters.add(delta); break;
+        case proto::MsgType::Modify: stats.modify_counters.add(delta); break;
+        default: break;
+    }
+}
+
+}  // namespace
+
+ReplayStats replay(OrderBook& book, const uint8_t* data, size_t len, const ReplayOptions& options) {
+    ReplayStats stats;
+    Reader reader(data, len);
+    const uint64_t trades_before = book.analytics().trades();
+    int64_t ts = 0, first_ts = 0;
+    const uint8_t* msg = nullptr;
+    const double speed = options.speed > 0.0 ? options.speed : 1.0;
+
+    PerfCounters pmu;
+    if (options.hardware_counters) {
+        stats.counters = pmu.open();
+        if (stats.counters) {
+            stats.counters_present = pmu.present();
+            pmu.enable();
+        } else {
+            stats.counters_error = pmu.error();
+        }
+    }
+
+    const auto start = Clock::now();
+    while (reader.next(ts, msg)) {
+        if (stats.commands == 0) first_ts = ts;
+        if (options.paced) {
+            const auto due = start + std::chrono::nanoseconds(
+                static_cast<int64_t>(static_cast<double>(ts - first_ts) / speed));
+            auto now = Clock::now();
+            // Sleep through long gaps, spin the last stretch for accuracy
+            if (due - now > std::chrono::milliseconds(2)) {
+                std::this_thread::sleep_until(due - std::chrono::milliseconds(1));
+                now = Clock::now();
+            }
+            while (now < due) now = Clock::now();
+            stats.lag.record(static_cast<uint64_t>(
+                std::chrono::duration_cast<std::chrono::nanoseconds>(now - due).count()));
+        }
+
+        book.advance_time(std::chrono::nanoseconds(ts));
+        if (stats.counters) {
+            counted_apply(book, msg, pmu, stats, options.per_command_latency);
+        } else if (options.per_command_latency) {
+            const auto t0 = Clock::now();
+            const bool accepted = apply(book, msg);
+            const auto t1 = Clock::now();
+            stats.latency.record(static_cast<uint64_t>(
+                std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0).count()));
+            if (!accepted) ++stats.rejected;
+        } else if (!apply(book, msg)) {
+            ++stats.rejected;
+        }
+        ++stats.commands;
+        if (options.checksum_interval && stats.commands % options.checksum_interval == 0) {
+            stats.checksums.push_back(book.checksum());
+        }
+    }
+    stats.elapsed_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count();
+    stats.recorded_span_ns = stats.commands ? ts - first_ts : 0;
+    stats.truncated = !reader.valid() || reader.truncated();
+    stats.trades = book.analytics().trades() - trades_before;
+    return stats;
+}
+
+}  // namespace cmdlog
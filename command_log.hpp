@@ -0,0 +1,127 @@
+#pragma once
+#include "histogram.hpp"
+#include "orderbook.hpp"
+#include "perf_counters.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Binary command log used to record and replay order flow.
+//
+// A 16-byte file header (8-byte magic, uint64 record count) is followed by
+// records of an int64 timestamp in nanoseconds and one order-entry message
+// from protocol.hpp (NewOrder, Cancel, Modify or Market), whose own header
+// carries its length. All fields are little-endian and 8-byte aligned, so a
+// mapped file is decoded in place with no per-record allocation.
+namespace cmdlog {
+
+constexpr char MAGIC[8] = {'L', 'O', 'B', 'C', 'M', 'D', '0', '1'};
+constexpr size_t FILE_HEADER_SIZE = 16;
+constexpr size_t RECORD_HEADER_SIZE = 8;
+
+// Appends records through a large buffer; close() patches the record count
+class Writer {
+public:
+    explicit Writer(size_t buffer_size = 1 << 20);
+    ~Writer();
+    Writer(const Writer&) = delete;
+    Writer& operator=(const Writer&) = delete;
+
+    bool open(const std::string& path);
+    // msg must be a complete order-entry message
+    void append(int64_t ts_ns, const uint8_t* msg);
+    // Already encoded records, e.g. produced by a parallel converter
+    void append_records(const uint8_t* records, size_t n_bytes, uint64_t n_records);
+    bool close();
+
+    uint64_t records() const { return count; }
+    bool ok() const { return !failed; }
+
+private:
+    int fd = -1;
+    std::vector<uint8_t> buf;
+    size_t len = 0;
+    uint64_t count = 0;
+    bool failed = false;
+
+    void write_all(const uint8_t* p, size_t n);
+    void drain();
+};
+
+// Read-only mapping of a whole file, advised for sequential access
+class MappedFile {
+public:
+    MappedFile() = default;
+    ~MappedFile();
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool open(const std::string& path);
+    void close();
+    const uint8_t* data() const { return base; }
+    size_t size() const { return length; }
+
+private:
+    const uint8_t* base = nullptr;
+    size_t length = 0;
+};
+
+// Walks the records of a log held in memory
+class Reader {
+public:
+    Reader(const uint8_t* data, size_t len);
+
+    bool valid() const { return ok; }
+    uint64_t declared_records() const { return declared; }
+    // Next complete record; false at the end or at a truncated/corrupt tail
+    bool next(int64_t& ts_ns, const uint8_t*& msg);
+    // True if next() stopped before the end of the data
+    bool truncated() const { return ok && pos != len; }
+
+private:
+    const uint8_t* data;
+    size_t len;
+    size_t pos = FILE_HEADER_SIZE;
+    uint64_t declared = 0;
+    bool ok = false;
+};
+
+// proto::apply() reduced to whether the message was accepted
+bool apply(OrderBook& book, const uint8_t* msg);
+
+struct ReplayOptions {
+    bool paced = false;      // hold each command until its recorded offset
+    double speed = 1.0;      // pace multiplier: 2.0 replays twice as fast
+    bool per_command_latency = true;
+    bool hardware_counters = false;  // per-command PMU counters, see perf_counters.hpp
+    size_t checksum_interval = 0;    // record book.checksum() every N commands; 0 = never
+};
+
+struct ReplayStats {
+    uint64_t commands = 0;
+    uint64_t rejected = 0;
+    uint64_t trades = 0;
+    int64_t elapsed_ns = 0;
+    int64_t recorded_span_ns = 0;  // last minus first timestamp
+    bool truncated = false;
+    LatencyHistogram latency;      // service time per command
+    LatencyHistogram lag;          // paced: how late each command started
+
+    // hardware_counters: false with counters_error set when the PMU is unavailable
+    bool counters = false;
+    std::string counters_error;
+    unsigned counters_present = 0;  // PerfCounters::present()
+    CounterTotals add_counters;     // resting NewOrders
+    CounterTotals match_counters;   // NewOrders that traded, and Market orders
+    CounterTotals cancel_counters;
+    CounterTotals modify_counters;
+
+    std::vector<uint64_t> checksums;  // after commands N, 2N, ... for checksum_interval N
+};
+
+// Replays every record in [data, data + len) into the book, advancing the
+// book's clock to each record's timestamp for good-till-time expiry
+ReplayStats replay(OrderBook& book, const uint8_t* data, size_t len, const ReplayOptions& options = {});
+
+}  // namespace cmdlog
@@ -0,0 +1,217 @@
+#include "concurrent_book.hpp"
+#include <algorithm>
+#include <cmath>
+#include <thread>
+
+namespace {
+
+void spin_pause(unsigned& spins) {
+    if (++spins < 64) {
+#if defined(__x86_64__) || defined(__i386__)
+        __builtin_ia32_pause();
+#endif
+    } else {
+        std::this_thread::yield();
+    }
+}
+
+}  // namespace
+
+// ---------------- locks ----------------
+
+void SpinLock::lock() {
+    unsigned spins = 0;
+    while (held.exchange(true, std::memory_order_acquire)) {
+        while (held.load(std::memory_order_relaxed)) spin_pause(spins);
+    }
+}
+
+void SpinRwLock::lock_shared() {
+    unsigned spins = 0;
+    for (;;) {
+        uint32_t s = state.load(std::memory_order_relaxed);
+        if (!(s & WRITER) && state.compare_exchange_weak(s, s + 1, std::memory_order_acquire)) return;
+        spin_pause(spins);
+    }
+}
+
+void SpinRwLock::lock() {
+    unsigned spins = 0;
+    for (;;) {
+        uint32_t s = state.load(std::memory_order_relaxed);
+        if (!(s & WRITER) && state.compare_exchange_weak(s, s | WRITER, std::memory_order_acquire)) break;
+        spin_pause(spins);
+    }
+    // New shared holders are held off; wait for the current ones to leave
+    while (state.load(std::memory_order_acquire) != WRITER) spin_pause(spins);
+}
+
+// ---------------- book ----------------
+
+ConcurrentOrderBook::ConcurrentOrderBook(double min_price_, double tick, size_t ticks_, size_t max_orders_)
+    : min_price(min_price_), tick_size(tick), ticks(static_cast<int64_t>(ticks_)), max_orders(max_orders_),
+      levels(new Level[ticks_]), slots(new OrderSlot[max_orders_ + 1]),
+      bid_bound(-1), ask_bound(static_cast<int64_t>(ticks_)) {}
+
+int64_t ConcurrentOrderBook::to_tick(double price) const {
+    const double x = (price - min_price) / tick_size;
+    const double t = std::nearbyint(x);
+    if (!(t >= 0.0) || t >= static_cast<double>(ticks) || std::fabs(x - t) > 1e-6) return -1;
+    return static_cast<int64_t>(t);
+}
+
+uint64_t ConcurrentOrderBook::take_id() {
+    const uint64_t id = next_id.fetch_add(1, std::memory_order_relaxed);
+    return id <= max_orders ? id : 0;
+}
+
+void ConcurrentOrderBook::drop_cancelled_front(Level& level) {
+    while (!level.queue.empty() && level.queue.front().qty == 0) {
+        level.queue.pop_front();
+        ++level.popped;
+    }
+}
+
+// Caller holds the level lock or the exclusive gate
+void ConcurrentOrderBook::rest(Level& level, int64_t tick, uint64_t id, int qty, bool is_bid) {
+    if (level.count == 0) {
+        // Only cancelled entries left, possibly of the other side
+        level.popped += level.queue.size();
+        level.queue.clear();
+    }
+    level.queue.push_back(Entry{id, qty});
+    OrderSlot& slot = slots[id];
+    slot.pos = level.pushed++;
+    level.total_qty += qty;
+    ++level.count;
+    level.is_bid = is_bid;
+    slot.tick.store(tick, std::memory_order_release);
+    resting.fetch_add(1, std::memory_order_relaxed);
+}
+
+uint64_t ConcurrentOrderBook::add_limit(double price, int qty, bool is_bid) {
+    if (qty <= 0) return 0;
+    const int64_t tick = to_tick(price);
+    if (tick < 0) return 0;
+    const uint64_t id = take_id();
+    if (id == 0) return 0;
+
+    gate.lock_shared();
+    bool crosses;
+    if (is_bid) {
+        int64_t b = bid_bound.load(std::memory_order_relaxed);
+        while (b < tick && !bid_bound.compare_exchange_weak(b, tick)) {}
+        crosses = ask_bound.load() <= tick;
+    } else {
+        int64_t a = ask_bound.load(std::memory_order_relaxed);
+        while (a > tick && !ask_bound.compare_exchange_weak(a, tick)) {}
+        crosses = bid_bound.load() >= tick;
+    }
+    if (!crosses) {
+        Level& level = levels[tick];
+        level.lock.lock();
+        rest(level, tick, id, qty, is_bid);
+        level.lock.unlock();
+        gate.unlock_shared();
+        return id;
+    }
+    gate.unlock_shared();
+
+    gate.lock();
+    const int left = match(id, tick, qty, is_bid);
+    if (left > 0) rest(levels[tick], tick, id, left, is_bid);  // own bound already covers tick
+    gate.unlock();
+    return id;
+}
+
+uint64_t ConcurrentOrderBook::add_market(int qty, bool is_bid) {
+    if (qty <= 0) return 0;
+    const uint64_t id = take_id();
+    if (id == 0) return 0;
+    gate.lock();
+    match(id, is_bid ? ticks - 1 : 0, qty, is_bid);
+    gate.unlock();
+    return id;
+}
+
+// Exclusive gate held. Walks the opposite side from its bound towards
+// limit_tick, then tightens that bound to where the walk stopped.
+int ConcurrentOrderBook::match(uint64_t id, int64_t limit_tick, int qty, bool is_bid) {
+    int64_t t = is_bid ? std::max<int64_t>(ask_bound.load(std::memory_order_relaxed), 0)
+                       : std::min<int64_t>(bid_bound.load(std::memory_order_relaxed), ticks - 1);
+    while (qty > 0 && (is_bid ? t <= limit_tick : t >= limit_tick)) {
+        Level& level = levels[t];
+        if (level.count == 0 || level.is_bid == is_bid) {
+            t += is_bid ? 1 : -1;
+            continue;
+        }
+        const double level_price = price_of(t);
+        drop_cancelled_front(level);
+        while (qty > 0 && level.count > 0) {
+            Entry& resting_order = level.queue.front();
+            const int trade_qty = std::min(qty, resting_order.qty);
+            if (is_bid) trades.emplace_back(id, resting_order.id, level_price, trade_qty);
+            else trades.emplace_back(resting_order.id, id, level_price, trade_qty);
+            resting_order.qty -= trade_qty;
+            level.total_qty -= trade_qty;
+            qty -= trade_qty;
+            if (resting_order.qty == 0) {
+                slots[resting_order.id].tick.store(-1, std::memory_order_relaxed);
+                level.queue.pop_front();
+                ++level.popped;
+                --level.count;
+                resting.fetch_sub(1, std::memory_order_relaxed);
+                drop_cancelled_front(level);
+            }
+        }
+        if (level.count == 0) t += is_bid ? 1 : -1;
+    }
+    if (is_bid) ask_bound.store(t);
+    else bid_bound.store(t);
+    return qty;
+}
+
+bool ConcurrentOrderBook::cancel(uint64_t id) {
+    if (id == 0 || id > max_orders) return false;
+    gate.lock_shared();
+    OrderSlot& slot = slots[id];
+    const int64_t tick = slot.tick.load(std::memory_order_acquire);
+    if (tick < 0) {
+        gate.unlock_shared();
+        return false;
+    }
+    Level& level = levels[tick];
+    level.lock.lock();
+    // Another thread may have cancelled it since the load
+    const bool live = slot.tick.load(std::memory_order_relaxed) == tick;
+    if (live) {
+        Entry& e = level.queue[static_cast<size_t>(slot.pos - level.popped)];
+        level.total_qty -= e.qty;
+        e.qty = 0;
+        --level.count;
+        slot.tick.store(-1, std::memory_order_relaxed);
+        resting.fetch_sub(1, std::memory_order_relaxed);
+        drop_cancelled_front(level);
+    }
+    level.lock.unlock();
+    gate.unlock_shared();
+    return live;
+}
+
+size_t ConcurrentOrderBook::depth(bool is_bid, LevelInfo* out, size_t max_levels) const {
+    gate.lock();
+    size_t n = 0;
+    if (is_bid) {
+        for (int64_t t = std::min(bid_bound.load(), ticks - 1); t >= 0 && n < max_levels; --t) {
+            const Level& level = levels[t];
+            if (level.count > 0 && level.is_bid) out[n++] = LevelInfo{price_of(t), level.total_qty, level.count};
+        }
+    } else {
+        for (int64_t t = std::max<int64_t>(ask_bound.load(), 0); t < ticks && n < max_levels; ++t) {
+            const Level& level = levels[t];
+            if (level.count > 0 && !level.is_bid) out[n++] = LevelInfo{price_of(t), level.total_qty, level.count};
+        }
+    }
+    gate.unlock();
+    return n;
+}
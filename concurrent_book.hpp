@@ -0,0 +1,112 @@
+#pragma once
+#include "book_events.hpp"
+#include "orderbook.hpp"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <vector>
+
+// Test-and-test-and-set lock; yields after a short spin so waiters do not
+// burn the time slice of a preempted holder
+class SpinLock {
+public:
+    void lock();
+    void unlock() { held.store(false, std::memory_order_release); }
+
+private:
+    std::atomic<bool> held{false};
+};
+
+// Shared/exclusive spin lock with writer preference: once a writer is
+// waiting, new shared holders wait until it has finished
+class SpinRwLock {
+public:
+    void lock_shared();
+    void unlock_shared() { state.fetch_sub(1, std::memory_order_release); }
+    void lock();
+    void unlock() { state.store(0, std::memory_order_release); }
+
+private:
+    static constexpr uint32_t WRITER = 1u << 31;
+    std::atomic<uint32_t> state{0};  // WRITER bit | shared holder count
+};
+
+// Order book that accepts commands from many threads at once.
+//
+// Prices live on a fixed tick ladder, one level per tick, each with its own
+// spin lock. Adds that do not cross and cancels hold a shared gate plus the
+// one level they touch, so commands at different prices run in parallel.
+// Crossing limit orders and market orders take the gate exclusively and
+// match with the rest of the book quiesced.
+//
+// The gate decision is lock-free. Each side keeps a bound on its best tick
+// that is never inside the real best. An add first widens its own side's
+// bound, then reads the opposite bound (both seq_cst). Of two concurrent
+// adds that would cross each other, at least one sees the other's bound and
+// takes the exclusive path, so the book never rests crossed. Matching is
+// price-time priority, the same as OrderBook.
+class ConcurrentOrderBook {
+public:
+    // Ticks min_price, min_price + tick, ... ; max_orders bounds ids issued
+    ConcurrentOrderBook(double min_price, double tick, size_t ticks, size_t max_orders = 1 << 20);
+    ConcurrentOrderBook(const ConcurrentOrderBook&) = delete;
+    ConcurrentOrderBook& operator=(const ConcurrentOrderBook&) = delete;
+
+    // Thread-safe. Return 0 for bad quantities, prices off the ladder or
+    // once max_orders ids have been issued.
+    uint64_t add_limit(double price, int qty, bool is_bid);
+    uint64_t add_market(int qty, bool is_bid);
+    bool cancel(uint64_t id);
+
+    size_t total_orders() const { return static_cast<size_t>(resting.load(std::memory_order_relaxed)); }
+    bool contains(uint64_t id) const {
+        return id != 0 && id <= max_orders && slots[id].tick.load(std::memory_order_acquire) >= 0;
+    }
+    // Consistent copy under the exclusive gate
+    size_t depth(bool is_bid, LevelInfo* out, size_t max_levels) const;
+    // Read only while no command is running
+    const std::vector<Trade>& get_trades() const { return trades; }
+
+    double price_of(int64_t tick) const { return min_price + static_cast<double>(tick) * tick_size; }
+
+private:
+    struct Entry {
+        uint64_t id;
+        int32_t qty;  // 0 once cancelled; skipped and dropped by matching
+    };
+    struct alignas(64) Level {
+        SpinLock lock;
+        std::deque<Entry> queue;
+        uint64_t popped = 0;  // entries dropped from the front so far
+        uint64_t pushed = 0;
+        int64_t total_qty = 0;
+        uint32_t count = 0;
+        bool is_bid = false;
+    };
+    // Where a resting order sits: level tick (-1 once gone) and its
+    // position in that level's push sequence
+    struct OrderSlot {
+        std::atomic<int64_t> tick{-1};
+        uint64_t pos = 0;
+    };
+
+    const double min_price, tick_size;
+    const int64_t ticks;
+    const size_t max_orders;
+    std::unique_ptr<Level[]> levels;
+    std::unique_ptr<OrderSlot[]> slots;  // indexed by id
+    mutable SpinRwLock gate;
+    std::atomic<uint64_t> next_id{1};
+    std::atomic<int64_t> resting{0};
+    alignas(64) std::atomic<int64_t> bid_bound;  // >= best bid tick, -1 if none
+    alignas(64) std::atomic<int64_t> ask_bound;  // <= best ask tick, ticks if none
+    std::vector<Trade> trades;                   // appended under the exclusive gate
+
+    int64_t to_tick(double price) const;
+    uint64_t take_id();
+    void rest(Level& level, int64_t tick, uint64_t id, int qty, bool is_bid);
+    int match(uint64_t id, int64_t limit_tick, int qty, bool is_bid);
+    static void drop_cancelled_front(Level& level);
+};
@@ -0,0 +1,137 @@
+#include "soa_level.hpp"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define LOB_X86 1
+#endif
+
+namespace soa {
+
+int64_t sum_qty_scalar(const int32_t* qty, size_t n) {
+    int64_t total = 0;
+    for (size_t i = 0; i < n; ++i) total += qty[i];
+    return total;
+}
+
+ptrdiff_t find_id_scalar(const uint64_t* ids, size_t n, uint64_t id) {
+    for (size_t i = 0; i < n; ++i) {
+        if (ids[i] == id) return static_cast<ptrdiff_t>(i);
+    }
+    return -1;
+}
+
+#ifdef LOB_X86
+namespace {
+
+__attribute__((target("avx2")))
+int64_t sum_qty_avx2(const int32_t* qty, size_t n) {
+    // Widen to 64-bit lanes so deep levels cannot overflow the accumulator
+    __m256i acc0 = _mm256_setzero_si256();
+    __m256i acc1 = _mm256_setzero_si256();
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(qty + i));
+        acc0 = _mm256_add_epi64(acc0, _mm256_cvtepi32_epi64(_mm256_castsi256_si128(v)));
+        acc1 = _mm256_add_epi64(acc1, _mm256_cvtepi32_epi64(_mm256_extracti128_si256(v, 1)));
+    }
+    alignas(32) int64_t lanes[4];
+    _mm256_store_si256(reinterpret_cast<__m256i*>(lanes), _mm256_add_epi64(acc0, acc1));
+    int64_t total = lanes[0] + lanes[1] + lanes[2] + lanes[3];
+    for (; i < n; ++i) total += qty[i];
+    return total;
+}
+
+__attribute__((target("avx2")))
+ptrdiff_t find_id_avx2(const uint64_t* ids, size_t n, uint64_t id) {
+    const __m256i needle = _mm256_set1_epi64x(static_cast<long long>(id));
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(ids + i));
+        __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(ids + i + 4));
+        int mask_a = _mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpeq_epi64(a, needle)));
+        int mask_b = _mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpeq_epi64(b, needle)));
+        int mask = mask_a | (mask_b << 4);
+        if (mask) return static_cast<ptrdiff_t>(i + __builtin_ctz(mask));
+    }
+    for (; i < n; ++i) {
+        if (ids[i] == id) return static_cast<ptrdiff_t>(i);
+    }
+    return -1;
+}
+
+const bool cpu_has_avx2 = __builtin_cpu_supports("avx2");
+
+}  // namespace
+#endif
+
+bool has_avx2() {
+#ifdef LOB_X86
+    return cpu_has_avx2;
+#else
+    return false;
+#endif
+}
+
+int64_t sum_qty(const int32_t* qty, size_t n) {
+#ifdef LOB_X86
+    if (cpu_has_avx2) return sum_qty_avx2(qty, n);
+#endif
+    return sum_qty_scalar(qty, n);
+}
+
+ptrdiff_t find_id(const uint64_t* ids, size_t n, uint64_t id) {
+#ifdef LOB_X86
+    if (cpu_has_avx2) return find_id_avx2(ids, n, id);
+#endif
+    return find_id_scalar(ids, n, id);
+}
+
+}  // namespace soa
+
+void SoaPriceLevel::push_back(uint64_t id, int qty, std::chrono::nanoseconds ts) {
+    ids.push_back(id);
+    qtys.push_back(qty);
+    stamps.push_back(ts.count());
+}
+
+void SoaPriceLevel::pop_front() {
+    ++head;
+    if (head == ids.size()) clear();
+    else if (head >= 64 && head * 2 >= ids.size()) compact();
+}
+
+void SoaPriceLevel::compact() {
+    ids.erase(ids.begin(), ids.begin() + head);
+    qtys.erase(qtys.begin(), qtys.begin() + head);
+    stamps.erase(stamps.begin(), stamps.begin() + head);
+    head = 0;
+}
+
+bool SoaPriceLevel::erase(uint64_t id) {
+    ptrdiff_t pos = find(id);
+    if (pos < 0) return false;
+    size_t at = head + static_cast<size_t>(pos);
+    ids.erase(ids.begin() + at);
+    qtys.erase(qtys.begin() + at);
+    stamps.erase(stamps.begin() + at);
+    return true;
+}
+
+void SoaPriceLevel::clear() {
+    ids.clear();
+    qtys.clear();
+    stamps.clear();
+    head = 0;
+}
+
+int64_t SoaPriceLevel::total_qty() const {
+    return soa::sum_qty(qty_data(), size());
+}
+
+ptrdiff_t SoaPriceLevel::find(uint64_t id) const {
+    return soa::find_id(id_data(), size(), id);
+}
+
+int64_t SoaPriceLevel::qty_ahead(size_t pos) const {
+    return soa::sum_qty(qty_data(), pos < size() ? pos : size());
+}
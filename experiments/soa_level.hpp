@@ -0,0 +1,53 @@
+#pragma once
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Structure-of-arrays FIFO for one price level.
+//
+// Ids, quantities and timestamps live in separate contiguous arrays, so
+// level-wide scans (total quantity, id search, queue-ahead sums) stream only
+// the column they need. On x86 these scans use AVX2 when the CPU supports it
+// and fall back to scalar loops otherwise. pop_front() advances a head index
+// and compacts lazily, keeping it O(1) amortized.
+class SoaPriceLevel {
+    std::vector<uint64_t> ids;
+    std::vector<int32_t> qtys;
+    std::vector<int64_t> stamps;  // nanoseconds
+    size_t head = 0;
+
+    void compact();
+
+public:
+    void push_back(uint64_t id, int qty, std::chrono::nanoseconds ts);
+    void pop_front();
+    bool erase(uint64_t id);
+    void clear();
+
+    bool empty() const { return head == ids.size(); }
+    size_t size() const { return ids.size() - head; }
+
+    // Positions are relative to the front of the queue
+    uint64_t id_at(size_t pos) const { return ids[head + pos]; }
+    int32_t& qty_at(size_t pos) { return qtys[head + pos]; }
+    int32_t qty_at(size_t pos) const { return qtys[head + pos]; }
+    std::chrono::nanoseconds ts_at(size_t pos) const { return std::chrono::nanoseconds(stamps[head + pos]); }
+    const int32_t* qty_data() const { return qtys.data() + head; }
+    const uint64_t* id_data() const { return ids.data() + head; }
+
+    int64_t total_qty() const;
+    // Position of id in the queue, or -1
+    ptrdiff_t find(uint64_t id) const;
+    // Sum of quantities strictly ahead of pos
+    int64_t qty_ahead(size_t pos) const;
+};
+
+// Column kernels, exposed for benchmarking the scalar and vector paths
+namespace soa {
+int64_t sum_qty(const int32_t* qty, size_t n);
+int64_t sum_qty_scalar(const int32_t* qty, size_t n);
+ptrdiff_t find_id(const uint64_t* ids, size_t n, uint64_t id);
+ptrdiff_t find_id_scalar(const uint64_t* ids, size_t n, uint64_t id);
+bool has_avx2();
+}
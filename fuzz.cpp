@@ -0,0 +1,445 @@
+// Differential fuzzer: random command sequences are applied both to
+// OrderBook and to a deliberately simple reference matcher, and trades,
+// return values, levels and total_orders() are compared after every step.
+//
+// Standalone:  ./fuzz [iterations [seed]]   random inputs
+//              ./fuzz FILE...                replay saved inputs
+// libFuzzer:   make fuzz-libfuzzer && ./fuzz_libfuzzer corpus/
+#include "orderbook.hpp"
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+// ---------------- reference matcher ----------------
+
+// Every order in one flat vector; all queries are linear scans. Nothing here
+// is clever, so it is easy to convince yourself it is right.
+class ReferenceBook {
+public:
+    struct RefOrder {
+        uint64_t id;
+        double price;
+        int qty;
+        bool is_bid;
+        uint32_t owner;
+        uint64_t seq;  // time priority
+    };
+    struct RefTrade {
+        uint64_t buyer, seller;
+        double price;
+        int qty;
+    };
+
+    std::vector<RefOrder> orders;
+    std::vector<RefTrade> trades;
+
+    uint64_t add_limit(double price, int qty, bool is_bid, uint32_t owner) {
+        if (qty <= 0) return 0;
+        uint64_t id = next_id++;
+        if (!auction) qty = match(id, price, qty, is_bid);
+        if (qty > 0) orders.push_back({id, price, qty, is_bid, owner, next_seq++});
+        return id;
+    }
+
+    uint64_t add_limit_gtt(double price, int qty, bool is_bid, int64_t expire_ns, uint32_t owner) {
+        if (expire_ns <= now_ns) return 0;
+        uint64_t id = add_limit(price, qty, is_bid, owner);
+        if (id != 0 && find(id) != orders.end()) timers[id] = (expire_ns + 999) / 1000;  // 1 us ticks, rounded up
+        return id;
+    }
+
+    uint64_t add_market(int qty, bool is_bid) {
+        if (qty <= 0 || auction) return 0;
+        uint64_t id = next_id++;
+        match(id, is_bid ? 1e9 : 0.0, qty, is_bid);
+        return id;
+    }
+
+    bool cancel(uint64_t id) {
+        auto it = find(id);
+        if (it == orders.end()) return false;
+        orders.erase(it);
+        return true;
+    }
+
+    bool modify(uint64_t id, double price, int qty) {
+        auto it = find(id);
+        if (it == orders.end()) return false;
+        if (qty <= 0) return cancel(id);
+        if (price == it->price && qty <= it->qty) {
+            it->qty = qty;
+            return true;
+        }
+        RefOrder o = *it;
+        orders.erase(it);
+        if (!auction) qty = match(id, price, qty, o.is_bid);
+        if (qty > 0) orders.push_back({id, price, qty, o.is_bid, o.owner, next_seq++});
+        return true;
+    }
+
+    size_t cancel_all(uint32_t owner) {
+        size_t before = orders.size();
+        orders.erase(std::remove_if(orders.begin(), orders.end(),
+                                    [&](const RefOrder& o) { return o.owner == owner; }),
+                     orders.end());
+        return before - orders.size();
+    }
+
+    size_t cancel_side(bool is_bid) {
+        size_t before = orders.size();
+        orders.erase(std::remove_if(orders.begin(), orders.end(),
+                                    [&](const RefOrder& o) { return o.is_bid == is_bid; }),
+                     orders.end());
+        return before - orders.size();
+    }
+
+    size_t advance_time(int64_t now) {
+        if (now <= now_ns) return 0;
+        now_ns = now;
+        const int64_t tick = now / 1000;
+        size_t expired = 0;
+        for (auto it = timers.begin(); it != timers.end();) {
+            if (it->second <= tick) {
+                if (cancel(it->first)) ++expired;
+                it = timers.erase(it);
+            } else {
+                ++it;
+            }
+        }
+        return expired;
+    }
+
+    void begin_auction() { auction = true; }
+
+    // Brute force over every level price in [best ask, best bid]: maximum
+    // volume, then minimum surplus, then the higher price when buyers are
+    // in surplus there
+    AuctionResult indicative_uncross() const {
+        AuctionResult best;
+        const RefOrder* bid = best_order(true, -1e18);
+        const RefOrder* ask = best_order(false, 1e18);
+        if (!bid || !ask || bid->price < ask->price) return best;
+        std::vector<double> prices;
+        for (const auto& o : orders) {
+            if (o.price >= ask->price && o.price <= bid->price) prices.push_back(o.price);
+        }
+        std::sort(prices.begin(), prices.end());
+        prices.erase(std::unique(prices.begin(), prices.end()), prices.end());
+
+        int64_t best_imbalance = 0;
+        for (double p : prices) {
+            int64_t buy = 0, sell = 0;
+            for (const auto& o : orders) {
+                if (o.is_bid && o.price >= p) buy += o.qty;
+                if (!o.is_bid && o.price <= p) sell += o.qty;
+            }
+            int64_t volume = std::min(buy, sell), imbalance = buy - sell;
+            if (volume > best.qty ||
+                (volume == best.qty && volume > 0 &&
+                 (std::llabs(imbalance) < std::llabs(best_imbalance) ||
+                  (std::llabs(imbalance) == std::llabs(best_imbalance) && imbalance > 0)))) {
+                best.price = p;
+                best.qty = volume;
+                best_imbalance = imbalance;
+            }
+        }
+        return best;
+    }
+
+    AuctionResult uncross() {
+        AuctionResult result = indicative_uncross();
+        auction = false;
+        if (result.qty == 0) return result;
+        for (;;) {
+            RefOrder* buy = best_order(true, -1e18);
+            RefOrder* sell = best_order(false, 1e18);
+            if (!buy || !sell || buy->price < result.price || sell->price > result.price) break;
+            int q = std::min(buy->qty, sell->qty);
+            trades.push_back({buy->id, sell->id, result.price, q});
+            buy->qty -= q;
+            sell->qty -= q;
+            remove_filled();
+        }
+        return result;
+    }
+
+    // Aggregated levels, best first, as OrderBook::depth reports them
+    std::vector<LevelInfo> levels(bool is_bid) const {
+        std::map<double, LevelInfo> by_price;
+        for (const auto& o : orders) {
+            if (o.is_bid != is_bid) continue;
+            LevelInfo& l = by_price[o.price];
+            l.price = o.price;
+            l.qty += o.qty;
+            ++l.count;
+        }
+        std::vector<LevelInfo> out;
+        for (const auto& kv : by_price) out.push_back(kv.second);
+        if (is_bid) std::reverse(out.begin(), out.end());
+        return out;
+    }
+
+private:
+    uint64_t next_id = 1;
+    uint64_t next_seq = 0;
+    bool auction = false;
+    int64_t now_ns = 0;
+    std::map<uint64_t, int64_t> timers;  // id → deadline tick
+
+    std::vector<RefOrder>::iterator find(uint64_t id) {
+        return std::find_if(orders.begin(), orders.end(), [&](const RefOrder& o) { return o.id == id; });
+    }
+
+    // Best order on one side that an incoming order at `limit` could trade
+    // with: best price first, then earliest
+    const RefOrder* best_order(bool is_bid, double limit) const {
+        const RefOrder* best = nullptr;
+        for (const auto& o : orders) {
+            if (o.is_bid != is_bid) continue;
+            if (is_bid ? o.price < limit : o.price > limit) continue;
+            if (!best || (is_bid ? o.price > best->price : o.price < best->price) ||
+                (o.price == best->price && o.seq < best->seq)) {
+                best = &o;
+            }
+        }
+        return best;
+    }
+    RefOrder* best_order(bool is_bid, double limit) {
+        return const_cast<RefOrder*>(static_cast<const ReferenceBook*>(this)->best_order(is_bid, limit));
+    }
+
+    void remove_filled() {
+        orders.erase(std::remove_if(orders.begin(), orders.end(), [](const RefOrder& o) { return o.qty == 0; }),
+                     orders.end());
+    }
+
+    // Strict price-time priority, trades at the resting price
+    int match(uint64_t id, double price, int qty, bool is_bid) {
+        while (qty > 0) {
+            RefOrder* resting = best_order(!is_bid, price);
+            if (!resting) break;
+            int q = std::min(qty, resting->qty);
+            if (is_bid) trades.push_back({id, resting->id, resting->price, q});
+            else trades.push_back({resting->id, id, resting->price, q});
+            resting->qty -= q;
+            qty -= q;
+            remove_filled();
+        }
+        return qty;
+    }
+};
+
+// Rebuilds levels from BookListener events, checking the event stream too
+class LevelMirror : public BookListener {
+public:
+    std::map<double, LevelInfo> bids, asks;
+    void on_level(bool is_bid, const LevelInfo& level) override {
+        auto& side = is_bid ? bids : asks;
+        if (level.qty == 0) side.erase(level.price);
+        else side[level.price] = level;
+    }
+};
+
+// ---------------- driver ----------------
+
+// Reads fuzz bytes as command parameters; zeros once exhausted
+struct ByteReader {
+    const uint8_t* p;
+    size_t left;
+    uint8_t byte() {
+        if (left == 0) return 0;
+        --left;
+        return *p++;
+    }
+    uint16_t u16() { return static_cast<uint16_t>(byte() | (byte() << 8)); }
+};
+
+[[noreturn]] void fail(size_t step, const std::string& what) {
+    std::cerr << "fuzz: mismatch at step " << step << ": " << what << std::endl;
+    std::abort();
+}
+
+bool same_level(const LevelInfo& a, const LevelInfo& b) {
+    return a.price == b.price && a.qty == b.qty && a.count == b.count;
+}
+
+void check_levels(size_t step, const OrderBook& ob, const ReferenceBook& ref, const LevelMirror& mirror) {
+    static std::vector<LevelInfo> got(4096);
+    for (bool is_bid : {true, false}) {
+        std::vector<LevelInfo> want = ref.levels(is_bid);
+        size_t n = ob.depth(is_bid, got.data(), got.size());
+        if (n != want.size()) fail(step, "level count");
+        for (size_t i = 0; i < n; ++i) {
+            if (!same_level(got[i], want[i])) fail(step, "level contents");
+        }
+        const auto& mirrored = is_bid ? mirror.bids : mirror.asks;
+        if (mirrored.size() != n) fail(step, "listener level count");
+        for (size_t i = 0; i < n; ++i) {
+            auto it = mirrored.find(got[i].price);
+            if (it == mirrored.end() || !same_level(it->second, got[i])) fail(step, "listener level contents");
+        }
+    }
+}
+
+void run(const uint8_t* data, size_t size) {
+    OrderBook ob;
+    ReferenceBook ref;
+    LevelMirror mirror;
+    ob.add_listener(&mirror);
+    ByteReader in{data, size};
+    std::vector<uint64_t> ids;  // ids handed out, for cancel/modify targets
+    int64_t now = 0;
+
+    // Small price grid so orders collide, cross and stack at levels
+    auto price = [&] { return 95.0 + static_cast<double>(in.byte() % 21) * 0.5; };
+    auto qty = [&] { int q = in.byte() % 64; return q == 63 ? -1 : q; };  // includes 0 and negative
+    auto target = [&]() -> uint64_t {
+        uint8_t b = in.byte();
+        if (ids.empty() || b == 255) return b;  // sometimes an unknown id
+        return ids[b % ids.size() + (ids.size() > 256 ? ids.size() - 256 : 0)];
+    };
+
+    for (size_t step = 0; in.left > 0; ++step) {
+        const uint8_t op = in.byte() % 12;
+        const bool is_bid = (in.byte() & 1) != 0;
+        switch (op) {
+            case 0: case 1: case 2: case 3: {
+                double p = price();
+                int q = qty();
+                uint32_t owner = in.byte() % 4;
+                uint64_t a = ob.add_limit(p, q, is_bid, owner);
+                if (a != ref.add_limit(p, q, is_bid, owner)) fail(step, "add_limit id");
+                if (a) ids.push_back(a);
+                break;
+            }
+            case 4: {
+                int q = qty();
+                uint64_t a = ob.add_market(q, is_bid);
+                if (a != ref.add_market(q, is_bid)) fail(step, "add_market id");
+                break;
+            }
+            case 5: case 6: {
+                uint64_t id = target();
+                if (ob.cancel(id) != ref.cancel(id)) fail(step, "cancel result");
+                break;
+            }
+            case 7: {
+                uint64_t id = target();
+                double p = price();
+                int q = qty();
+                if (ob.modify(id, p, q) != ref.modify(id, p, q)) fail(step, "modify result");
+                break;
+            }
+            case 8: {
+                uint8_t kind = in.byte() % 8;
+                if (kind == 0) {
+                    if (ob.cancel_side(is_bid) != ref.cancel_side(is_bid)) fail(step, "cancel_side count");
+                } else {
+                    uint32_t owner = in.byte() % 4;
+                    if (ob.cancel_all(owner) != ref.cancel_all(owner)) fail(step, "cancel_all count");
+                }
+                break;
+            }
+            case 9: {
+                double p = price();
+                int q = qty();
+                int64_t expire = now + in.u16() * 100 - 2000;  // sometimes already past
+                uint64_t a = ob.add_limit(p, q, is_bid, std::chrono::nanoseconds(expire), 1);
+                if (a != ref.add_limit_gtt(p, q, is_bid, expire, 1)) fail(step, "gtt add_limit id");
+                if (a) ids.push_back(a);
+                break;
+            }
+            case 10: {
+                now += in.u16() * 10;
+                if (ob.advance_time(std::chrono::nanoseconds(now)) != ref.advance_time(now)) {
+                    fail(step, "advance_time expired count");
+                }
+                break;
+            }
+            case 11: {
+                if (!ob.auction_active()) {
+                    if (in.byte() % 4 == 0) {
+                        ob.begin_auction();
+                        ref.begin_auction();
+                    }
+                    break;
+                }
+                AuctionResult a = ob.indicative_uncross(), b = ref.indicative_uncross();
+                if (a.price != b.price || a.qty != b.qty) fail(step, "indicative_uncross");
+                if (is_bid) {
+                    a = ob.uncross();
+                    b = ref.uncross();
+                    if (a.price != b.price || a.qty != b.qty) fail(step, "uncross");
+                }
+                break;
+            }
+        }
+
+        // Same trades in the same order, same resting state
+        const auto& trades = ob.get_trades();
+        if (trades.size() != ref.trades.size()) fail(step, "trade count");
+        for (size_t i = trades.size(); i-- > 0;) {
+            const auto& t = trades[i];
+            const auto& r = ref.trades[i];
+            if (t.buyer_id != r.buyer || t.seller_id != r.seller || t.price != r.price || t.qty != r.qty) {
+                fail(step, "trade " + std::to_string(i));
+            }
+            if (trades.size() - i > 64) break;  // older trades were checked on earlier steps
+        }
+        if (ob.total_orders() != ref.orders.size()) fail(step, "total_orders");
+        for (const auto& o : ref.orders) {
+            if (!ob.contains(o.id)) fail(step, "order " + std::to_string(o.id) + " missing");
+        }
+        check_levels(step, ob, ref, mirror);
+    }
+    ob.remove_listener(&mirror);
+}
+
+}  // namespace
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+    run(data, size);
+    return 0;
+}
+
+#ifndef LOB_LIBFUZZER
+int main(int argc, char** argv) {
+    // Saved inputs (e.g. crash files) are replayed as given
+    if (argc > 1 && !std::isdigit(static_cast<unsigned char>(argv[1][0]))) {
+        for (int i = 1; i < argc; ++i) {
+            std::ifstream f(argv[i], std::ios::binary);
+            std::vector<uint8_t> bytes((std::istreambuf_iterator<char>(f)), std::istreambuf_iterator<char>());
+            run(bytes.data(), bytes.size());
+            std::cout << argv[i] << ": ok\n";
+        }
+        return 0;
+    }
+
+    const long iterations = argc > 1 ? std::atol(argv[1]) : 1000;
+    const uint64_t seed = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 1;
+    std::mt19937_64 rng(seed);
+    std::vector<uint8_t> input;
+    for (long it = 0; it < iterations; ++it) {
+        input.resize(64 + rng() % 8192);
+        for (auto& b : input) b = static_cast<uint8_t>(rng());
+        // Keep the input so a failure can be replayed with ./fuzz FILE
+        std::ofstream("fuzz-last-input.bin", std::ios::binary)
+            .write(reinterpret_cast<const char*>(input.data()), static_cast<std::streamsize>(input.size()));
+        run(input.data(), input.size());
+    }
+    std::remove("fuzz-last-input.bin");
+    std::cout << "fuzz: " << iterations << " random inputs matched the reference (seed " << seed << ")\n";
+    return 0;
+}
+#endif
@@ -0,0 +1,50 @@
+#include "gateway.hpp"
+#include "command_log.hpp"
+#include <cstring>
+
+OrderGateway::OrderGateway(size_t sessions, size_t ring_capacity) {
+    rings.reserve(sessions);
+    for (size_t i = 0; i < sessions; ++i) rings.push_back(std::make_unique<Session>(ring_capacity));
+}
+
+bool OrderGateway::submit(size_t session, const uint8_t* msg) {
+    using namespace proto;
+    size_t len = 0;
+    switch (msg_type(msg)) {
+        case MsgType::NewOrder: len = NEW_ORDER_SIZE; break;
+        case MsgType::Cancel: len = CANCEL_SIZE; break;
+        case MsgType::Modify: len = MODIFY_SIZE; break;
+        case MsgType::Market: len = MARKET_SIZE; break;
+        default: return false;
+    }
+    if (msg_length(msg) != len) return false;
+
+    Session& s = *rings[session];
+    Slot slot;
+    std::memcpy(slot.msg, msg, len);
+    if (!s.ring.try_push(slot)) {
+        s.full.store(s.full.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        return false;
+    }
+    s.submitted.store(s.submitted.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    return true;
+}
+
+size_t OrderGateway::drain(OrderBook& book, size_t quantum) {
+    return poll([&](size_t, const uint8_t* msg) { cmdlog::apply(book, msg); }, quantum);
+}
+
+OrderGateway::SessionStats OrderGateway::stats(size_t session) const {
+    const Session& s = *rings[session];
+    SessionStats out;
+    out.submitted = s.submitted.load(std::memory_order_relaxed);
+    out.full = s.full.load(std::memory_order_relaxed);
+    out.processed = s.processed;
+    return out;
+}
+
+size_t OrderGateway::pending() const {
+    size_t n = 0;
+    for (const auto& s : rings) n += s->ring.size();
+    return n;
+}
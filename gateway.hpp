@@ -0,0 +1,80 @@
+#pragma once
+#include "orderbook.hpp"
+#include "protocol.hpp"
+#include "spsc_ring.hpp"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// Multi-session intake in front of a single-threaded book.
+//
+// Every client session gets its own SPSC ring of order-entry messages
+// (protocol.hpp), so session threads never contend with each other. The
+// matching thread polls the rings round-robin and takes at most `quantum`
+// messages from each per pass, so a flooding session cannot starve the rest;
+// a full ring pushes back on its own session only.
+class OrderGateway {
+public:
+    // Largest inbound message (NewOrder); smaller ones share the slot size
+    static constexpr size_t SLOT_SIZE = proto::NEW_ORDER_SIZE;
+    struct Slot {
+        alignas(8) uint8_t msg[SLOT_SIZE];
+    };
+
+    struct SessionStats {
+        uint64_t submitted = 0;
+        uint64_t full = 0;        // submits refused because the ring was full
+        uint64_t processed = 0;
+    };
+
+    explicit OrderGateway(size_t sessions, size_t ring_capacity = 4096);
+
+    size_t sessions() const { return rings.size(); }
+
+    // Session thread (one per session): queues a complete NewOrder, Cancel,
+    // Modify or Market message. False if the ring is full or the message is
+    // not an inbound order-entry message.
+    bool submit(size_t session, const uint8_t* msg);
+
+    // Matching thread: one round-robin pass, starting one session further on
+    // each call, handing up to quantum messages per session to
+    // handler(session, msg). Returns the number handled.
+    template <class Handler>
+    size_t poll(Handler&& handler, size_t quantum = 32);
+
+    // poll() that applies each message to the book (cmdlog::apply)
+    size_t drain(OrderBook& book, size_t quantum = 32);
+
+    // Counters are updated without locks; read them once traffic has stopped
+    SessionStats stats(size_t session) const;
+    // Total messages queued across sessions (approximate under traffic)
+    size_t pending() const;
+
+private:
+    struct Session {
+        explicit Session(size_t capacity) : ring(capacity) {}
+        SpscRing<Slot> ring;
+        alignas(64) std::atomic<uint64_t> submitted{0}, full{0};  // session thread
+        alignas(64) uint64_t processed = 0;                       // matching thread
+    };
+
+    std::vector<std::unique_ptr<Session>> rings;
+    size_t cursor = 0;  // first session of the next pass
+};
+
+template <class Handler>
+size_t OrderGateway::poll(Handler&& handler, size_t quantum) {
+    const size_t n = rings.size();
+    size_t handled = 0;
+    for (size_t k = 0; k < n; ++k) {
+        const size_t s = (cursor + k) % n;
+        Session& session = *rings[s];
+        const size_t got = session.ring.consume(quantum, [&](const Slot& slot) { handler(s, slot.msg); });
+        session.processed += got;
+        handled += got;
+    }
+    cursor = n ? (cursor + 1) % n : 0;
+    return handled;
+}
@@ -0,0 +1,47 @@
+#include "histogram.hpp"
+#include <algorithm>
+#include <iomanip>
+#include <ostream>
+
+void LatencyHistogram::merge(const LatencyHistogram& other) {
+    for (int i = 0; i < BUCKETS; ++i) counts[i] += other.counts[i];
+    total += other.total;
+    sum += other.sum;
+    max_ns = std::max(max_ns, other.max_ns);
+    min_ns = std::min(min_ns, other.min_ns);
+}
+
+void LatencyHistogram::clear() {
+    *this = LatencyHistogram();
+}
+
+uint64_t LatencyHistogram::upper_bound(int idx) {
+    if (idx < SUB) return static_cast<uint64_t>(idx);
+    int shift = idx / SUB - 1;
+    uint64_t sub = static_cast<uint64_t>(idx % SUB + SUB);
+    return (sub << shift) + ((uint64_t{1} << shift) - 1);
+}
+
+uint64_t LatencyHistogram::percentile(double p) const {
+    if (total == 0) return 0;
+    uint64_t rank = static_cast<uint64_t>(p / 100.0 * static_cast<double>(total) + 0.5);
+    rank = std::clamp<uint64_t>(rank, 1, total);
+    uint64_t seen = 0;
+    for (int i = 0; i < BUCKETS; ++i) {
+        seen += counts[i];
+        if (seen >= rank) return std::min(upper_bound(i), max_ns);
+    }
+    return max_ns;
+}
+
+void LatencyHistogram::print(std::ostream& os, const char* name) const {
+    os << std::left << std::setw(20) << name << std::right
+       << " n=" << total
+       << " min=" << min()
+       << " p50=" << percentile(50)
+       << " p90=" << percentile(90)
+       << " p99=" << percentile(99)
+       << " p99.9=" << percentile(99.9)
+       << " p99.99=" << percentile(99.99)
+       << " max=" << max() << " ns\n";
+}
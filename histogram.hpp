@@ -0,0 +1,51 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+
+// Fixed-size log-linear latency histogram.
+//
+// Values below 2^SUB_BITS land in exact buckets; above that every power of two
+// is split into 2^SUB_BITS linear sub-buckets, so any recorded value is
+// reported within ~3% and record() is a few instructions with no allocation.
+class LatencyHistogram {
+public:
+    static constexpr int SUB_BITS = 5;
+    static constexpr int SUB = 1 << SUB_BITS;
+    static constexpr int BUCKETS = (64 - SUB_BITS + 1) * SUB;
+
+    void record(uint64_t ns) {
+        ++counts[index(ns)];
+        ++total;
+        sum += ns;
+        if (ns > max_ns) max_ns = ns;
+        if (ns < min_ns) min_ns = ns;
+    }
+
+    void merge(const LatencyHistogram& other);
+    void clear();
+
+    uint64_t count() const { return total; }
+    uint64_t min() const { return total ? min_ns : 0; }
+    uint64_t max() const { return max_ns; }
+    double mean() const { return total ? static_cast<double>(sum) / static_cast<double>(total) : 0.0; }
+    // Upper bound of the bucket holding the p-th percentile (0 < p <= 100)
+    uint64_t percentile(double p) const;
+
+    // One line: count, min, p50, p90, p99, p99.9, p99.99, max
+    void print(std::ostream& os, const char* name) const;
+
+private:
+    uint64_t counts[BUCKETS] = {};
+    uint64_t total = 0;
+    uint64_t sum = 0;
+    uint64_t max_ns = 0;
+    uint64_t min_ns = UINT64_MAX;
+
+    static int index(uint64_t v) {
+        if (v < static_cast<uint64_t>(SUB)) return static_cast<int>(v);
+        int shift = 63 - __builtin_clzll(v) - SUB_BITS;
+        return (shift + 1) * SUB + static_cast<int>((v >> shift) - SUB);
+    }
+    static uint64_t upper_bound(int idx);
+};
@@ -0,0 +1,35 @@
+#include "text_import.hpp"
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+
+int main(int argc, char** argv) {
+    if (argc < 3) {
+        std::cerr << "usage: import_text IN.csv OUT.bin [--threads N]\n"
+                     "  lines: ts,N,B|S,price,qty[,owner[,expire_ns]]  ts,X,id  "
+                     "ts,M,id,price,qty  ts,K,B|S,qty\n";
+        return 2;
+    }
+    unsigned threads = 0;
+    if (argc == 5 && std::strcmp(argv[3], "--threads") == 0) threads = static_cast<unsigned>(std::atoi(argv[4]));
+
+    textimport::ImportStats stats;
+    auto start = std::chrono::steady_clock::now();
+    if (!textimport::convert_file(argv[1], argv[2], stats, threads)) {
+        std::cerr << "import_text: cannot convert " << argv[1] << " to " << argv[2] << "\n";
+        return 1;
+    }
+    double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::cout << std::fixed << std::setprecision(3);
+    std::cout << "lines:      " << stats.lines << "\n";
+    std::cout << "records:    " << stats.records << "\n";
+    std::cout << "errors:     " << stats.errors;
+    if (stats.errors) std::cout << " (first at line " << stats.first_error_line << ")";
+    std::cout << "\n";
+    std::cout << "elapsed:    " << secs << " s, "
+              << static_cast<double>(stats.bytes) / secs / 1e9 << " GB/s\n";
+    return stats.errors ? 1 : 0;
+}
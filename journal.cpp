@@ -0,0 +1,327 @@
+#include "journal.hpp"
+#include "command_log.hpp"
+#include "protocol.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#include <vector>
+
+namespace journal {
+
+namespace {
+
+// ---------------- write() + fdatasync() ----------------
+
+class SyncBackend : public Backend {
+public:
+    ~SyncBackend() override { close(); }
+    const char* name() const override { return "write+fdatasync"; }
+
+    bool open(const std::string& path, size_t buffer_size, bool sync) override {
+        close();
+        with_sync = sync;
+        fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        for (auto& b : bufs) b.assign(buffer_size, 0);
+        failed = fd < 0;
+        return !failed;
+    }
+
+    uint8_t* buffer(int index) override { return bufs[index].data(); }
+
+    bool submit(int index, size_t len, uint64_t offset) override {
+        const uint8_t* p = bufs[index].data();
+        while (len > 0 && !failed) {
+            const ssize_t r = ::pwrite(fd, p, len, static_cast<off_t>(offset));
+            if (r <= 0) {
+                if (r < 0 && errno == EINTR) continue;
+                failed = true;
+                break;
+            }
+            p += r;
+            len -= static_cast<size_t>(r);
+            offset += static_cast<uint64_t>(r);
+        }
+        if (!failed && with_sync && ::fdatasync(fd) != 0) failed = true;
+        return !failed;
+    }
+
+    bool wait() override { return !failed; }
+
+    void close() override {
+        if (fd >= 0) ::close(fd);
+        fd = -1;
+    }
+
+private:
+    int fd = -1;
+    bool with_sync = true;
+    bool failed = false;
+    std::vector<uint8_t> bufs[BUFFERS];
+};
+
+// ---------------- io_uring ----------------
+
+int uring_setup(unsigned entries, io_uring_params* p) {
+    return static_cast<int>(syscall(__NR_io_uring_setup, entries, p));
+}
+
+int uring_enter(int fd, unsigned to_submit, unsigned min_complete, unsigned flags) {
+    return static_cast<int>(syscall(__NR_io_uring_enter, fd, to_submit, min_complete, flags, nullptr, 0));
+}
+
+int uring_register(int fd, unsigned opcode, const void* arg, unsigned nr_args) {
+    return static_cast<int>(syscall(__NR_io_uring_register, fd, opcode, arg, nr_args));
+}
+
+class UringBackend : public Backend {
+public:
+    ~UringBackend() override { close(); }
+    const char* name() const override { return "io_uring"; }
+
+    bool open(const std::string& path, size_t buffer_size, bool sync) override {
+        close();
+        failed = false;
+        with_sync = sync;
+        io_uring_params p;
+        std::memset(&p, 0, sizeof(p));
+        ring_fd = uring_setup(8, &p);
+        if (ring_fd < 0) return false;
+
+        // Submission and completion rings share one mapping on kernels with
+        // IORING_FEAT_SINGLE_MMAP (5.4+)
+        sq_len = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+        cq_len = p.cq_off.cqes + p.cq_entries * sizeof(io_uring_cqe);
+        const bool single = p.features & IORING_FEAT_SINGLE_MMAP;
+        if (single) sq_len = cq_len = std::max(sq_len, cq_len);
+        sq_ptr = mmap(nullptr, sq_len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_SQ_RING);
+        if (sq_ptr == MAP_FAILED) return fail_open();
+        cq_ptr = single ? sq_ptr
+                        : mmap(nullptr, cq_len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd,
+                               IORING_OFF_CQ_RING);
+        if (cq_ptr == MAP_FAILED) return fail_open();
+        sqes_len = p.sq_entries * sizeof(io_uring_sqe);
+        void* s = mmap(nullptr, sqes_len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_SQES);
+        if (s == MAP_FAILED) return fail_open();
+        sqes = static_cast<io_uring_sqe*>(s);
+
+        auto* sq = static_cast<uint8_t*>(sq_ptr);
+        sq_tail = reinterpret_cast<unsigned*>(sq + p.sq_off.tail);
+        sq_mask = *reinterpret_cast<unsigned*>(sq + p.sq_off.ring_mask);
+        sq_array = reinterpret_cast<unsigned*>(sq + p.sq_off.array);
+        auto* cq = static_cast<uint8_t*>(cq_ptr);
+        cq_head = reinterpret_cast<unsigned*>(cq + p.cq_off.head);
+        cq_tail = reinterpret_cast<unsigned*>(cq + p.cq_off.tail);
+        cq_mask = *reinterpret_cast<unsigned*>(cq + p.cq_off.ring_mask);
+        cqes = reinterpret_cast<io_uring_cqe*>(cq + p.cq_off.cqes);
+
+        // Page-aligned buffers pinned once, so each write skips the page lookups
+        buf_size = (buffer_size + 4095) & ~size_t{4095};
+        iovec iov[BUFFERS];
+        for (int i = 0; i < BUFFERS; ++i) {
+            bufs[i] = static_cast<uint8_t*>(std::aligned_alloc(4096, buf_size));
+            if (!bufs[i]) return fail_open();
+            iov[i].iov_base = bufs[i];
+            iov[i].iov_len = buf_size;
+        }
+        if (uring_register(ring_fd, IORING_REGISTER_BUFFERS, iov, BUFFERS) < 0) return fail_open();
+
+        file_fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (file_fd < 0) return fail_open();
+        return true;
+    }
+
+    uint8_t* buffer(int index) override { return bufs[index]; }
+
+    bool submit(int index, size_t len, uint64_t offset) override {
+        if (failed) return false;
+        unsigned tail = *sq_tail;  // only this thread moves the tail
+
+        io_uring_sqe* w = next_sqe(tail);
+        w->opcode = IORING_OP_WRITE_FIXED;
+        w->fd = file_fd;
+        w->addr = reinterpret_cast<uint64_t>(bufs[index]);
+        w->len = static_cast<uint32_t>(len);
+        w->off = offset;
+        w->buf_index = static_cast<uint16_t>(index);
+        w->user_data = len << 1;
+        const unsigned n = with_sync ? 2 : 1;
+        if (with_sync) {
+            w->flags = IOSQE_IO_LINK;  // the sync starts only after the write succeeds
+            io_uring_sqe* f = next_sqe(tail);
+            f->opcode = IORING_OP_FSYNC;
+            f->fd = file_fd;
+            f->fsync_flags = IORING_FSYNC_DATASYNC;
+            f->user_data = 1;
+        }
+
+        __atomic_store_n(sq_tail, tail, __ATOMIC_RELEASE);
+        int submitted;
+        do {
+            submitted = uring_enter(ring_fd, n, 0, 0);
+        } while (submitted < 0 && errno == EINTR);
+        if (submitted != static_cast<int>(n)) failed = true;
+        else pending += n;
+        return !failed;
+    }
+
+    bool wait() override {
+        while (pending > 0) {
+            unsigned head = *cq_head;
+            if (head == __atomic_load_n(cq_tail, __ATOMIC_ACQUIRE)) {
+                if (uring_enter(ring_fd, 0, 1, IORING_ENTER_GETEVENTS) < 0 && errno != EINTR) {
+                    failed = true;
+                    return false;
+                }
+                continue;
+            }
+            const io_uring_cqe& c = cqes[head & cq_mask];
+            if (c.user_data & 1) {
+                if (c.res < 0) failed = true;   // sync failed, or cancelled by a short write
+            } else if (c.res < 0 || static_cast<uint64_t>(c.res) != c.user_data >> 1) {
+                failed = true;
+            }
+            __atomic_store_n(cq_head, head + 1, __ATOMIC_RELEASE);
+            --pending;
+        }
+        return !failed;
+    }
+
+    void close() override {
+        if (file_fd >= 0 && pending > 0) wait();
+        if (file_fd >= 0) ::close(file_fd);
+        file_fd = -1;
+        if (sqes) munmap(sqes, sqes_len);
+        if (cq_ptr && cq_ptr != MAP_FAILED && cq_ptr != sq_ptr) munmap(cq_ptr, cq_len);
+        if (sq_ptr && sq_ptr != MAP_FAILED) munmap(sq_ptr, sq_len);
+        sqes = nullptr;
+        sq_ptr = cq_ptr = nullptr;
+        if (ring_fd >= 0) ::close(ring_fd);  // also unregisters the buffers
+        ring_fd = -1;
+        for (auto& b : bufs) {
+            std::free(b);
+            b = nullptr;
+        }
+        pending = 0;
+    }
+
+private:
+    int ring_fd = -1, file_fd = -1;
+    void *sq_ptr = nullptr, *cq_ptr = nullptr;
+    size_t sq_len = 0, cq_len = 0, sqes_len = 0;
+    io_uring_sqe* sqes = nullptr;
+    unsigned *sq_tail = nullptr, *sq_array = nullptr, *cq_head = nullptr, *cq_tail = nullptr;
+    unsigned sq_mask = 0, cq_mask = 0;
+    io_uring_cqe* cqes = nullptr;
+    uint8_t* bufs[BUFFERS] = {};
+    size_t buf_size = 0;
+    unsigned pending = 0;  // completions still to reap
+    bool with_sync = true;
+    bool failed = false;
+
+    io_uring_sqe* next_sqe(unsigned& tail) {
+        const unsigned idx = tail & sq_mask;
+        io_uring_sqe* sqe = &sqes[idx];
+        std::memset(sqe, 0, sizeof(*sqe));
+        sq_array[idx] = idx;
+        ++tail;
+        return sqe;
+    }
+
+    bool fail_open() {
+        close();
+        return false;
+    }
+};
+
+}  // namespace
+
+std::unique_ptr<Backend> make_sync_backend() { return std::make_unique<SyncBackend>(); }
+std::unique_ptr<Backend> make_uring_backend() { return std::make_unique<UringBackend>(); }
+
+// ---------------- Journal ----------------
+
+Journal::Journal(std::unique_ptr<Backend> b, const Options& options) : backend(std::move(b)), opts(options) {
+    // An empty buffer must always fit the largest record, or append() overruns it
+    opts.buffer_size = std::max(opts.buffer_size, cmdlog::RECORD_HEADER_SIZE + proto::MAX_REQUEST_SIZE);
+}
+
+Journal::~Journal() { close(); }
+
+bool Journal::open(const std::string& path) {
+    close();
+    failed = !backend->open(path, opts.buffer_size, true);
+    if (failed) return false;
+    is_open = true;
+    active = 0;
+    offset = 0;
+    records = in_flight = durable_records = group_count = 0;
+    staged = 0;
+    // The header goes out with the first group; close() patches its count
+    uint8_t* buf = backend->buffer(active);
+    std::memcpy(buf, cmdlog::MAGIC, sizeof(cmdlog::MAGIC));
+    proto::store<uint64_t>(buf + 8, 0);
+    len = cmdlog::FILE_HEADER_SIZE;
+    return true;
+}
+
+void Journal::append(int64_t ts_ns, const uint8_t* msg) {
+    if (!is_open) return;
+    const size_t n = cmdlog::RECORD_HEADER_SIZE + proto::msg_length(msg);
+    if (len + n > opts.buffer_size) commit();
+    uint8_t* p = backend->buffer(active) + len;
+    proto::store<int64_t>(p, ts_ns);
+    std::memcpy(p + cmdlog::RECORD_HEADER_SIZE, msg, n - cmdlog::RECORD_HEADER_SIZE);
+    len += n;
+    ++staged;
+    ++records;
+    if (staged >= opts.group_records) commit();
+}
+
+bool Journal::reap() {
+    if (in_flight == 0) return !failed;
+    if (!backend->wait()) failed = true;
+    else durable_records += in_flight;
+    in_flight = 0;
+    return !failed;
+}
+
+bool Journal::commit() {
+    if (!is_open || len == 0) return !failed;
+    // The other buffer may still be in flight; one group at a time
+    reap();
+    if (!failed && !backend->submit(active, len, offset)) failed = true;
+    in_flight = staged;
+    ++group_count;
+    offset += len;
+    active ^= 1;
+    len = 0;
+    staged = 0;
+    return !failed;
+}
+
+bool Journal::sync() {
+    commit();
+    return reap();
+}
+
+bool Journal::close() {
+    if (!is_open) return !failed;
+    sync();
+    // Patch the header's record count through the same backend
+    uint8_t* buf = backend->buffer(active);
+    std::memcpy(buf, cmdlog::MAGIC, sizeof(cmdlog::MAGIC));
+    proto::store<uint64_t>(buf + 8, records);
+    if (!backend->submit(active, cmdlog::FILE_HEADER_SIZE, 0) || !backend->wait()) failed = true;
+    backend->close();
+    is_open = false;
+    return !failed;
+}
+
+}  // namespace journal
@@ -0,0 +1,90 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+// Durable command journal with group commit.
+//
+// The file is a command log (command_log.hpp), so `replay` reads a journal
+// directly. Records are appended into one of two staging buffers. commit()
+// hands the active buffer to the backend as one write and one fdatasync,
+// so a single sync makes a whole group of commands durable. The other
+// buffer keeps filling meanwhile.
+namespace journal {
+
+// Writes staged buffers at given offsets and makes them durable
+class Backend {
+public:
+    virtual ~Backend() = default;
+    virtual const char* name() const = 0;
+    // Creates the file and BUFFERS staging buffers of buffer_size bytes.
+    // Without sync, submit() only writes and skips the data sync.
+    virtual bool open(const std::string& path, size_t buffer_size, bool sync) = 0;
+    virtual uint8_t* buffer(int index) = 0;
+    // Starts writing len bytes of a buffer at offset followed by a data sync.
+    // May return before they are durable; the buffer stays busy until wait().
+    virtual bool submit(int index, size_t len, uint64_t offset) = 0;
+    // Blocks until every submitted write (and sync) is done; false if any failed
+    virtual bool wait() = 0;
+    virtual void close() = 0;
+
+    static constexpr int BUFFERS = 2;
+};
+
+// pwrite() + fdatasync(), complete before submit() returns
+std::unique_ptr<Backend> make_sync_backend();
+// io_uring through raw syscalls: buffers registered once, each submit() is
+// a WRITE_FIXED linked to an FSYNC(DATASYNC), or the write alone without
+// sync, and returns without waiting.
+// open() fails when the kernel or a seccomp filter refuses io_uring.
+std::unique_ptr<Backend> make_uring_backend();
+
+struct Options {
+    size_t buffer_size = 1 << 20;  // raised to fit at least one record
+    size_t group_records = 64;  // append() commits after this many records
+};
+
+class Journal {
+public:
+    explicit Journal(std::unique_ptr<Backend> backend, const Options& options = {});
+    ~Journal();
+    Journal(const Journal&) = delete;
+    Journal& operator=(const Journal&) = delete;
+
+    bool open(const std::string& path);
+    // Stages one command-log record; commits once group_records are staged
+    // or the buffer is full. msg must be a complete order-entry message.
+    void append(int64_t ts_ns, const uint8_t* msg);
+    // Submits everything staged as one group, first waiting for the previous
+    // group if its buffer is still in flight
+    bool commit();
+    // commit() and wait: every appended record is durable on return
+    bool sync();
+    // Syncs, patches the record count and closes; false if any write failed
+    bool close();
+
+    const char* backend_name() const { return backend->name(); }
+    uint64_t appended() const { return records; }
+    uint64_t durable() const { return durable_records; }
+    uint64_t groups() const { return group_count; }
+    bool ok() const { return !failed; }
+
+private:
+    std::unique_ptr<Backend> backend;
+    Options opts;
+    bool is_open = false;
+    bool failed = false;
+    int active = 0;             // buffer being filled
+    size_t len = 0;             // bytes staged in it
+    size_t staged = 0;          // records staged in it
+    uint64_t offset = 0;        // file offset of the active buffer
+    uint64_t records = 0;
+    uint64_t in_flight = 0;     // records submitted but not yet known durable
+    uint64_t durable_records = 0;
+    uint64_t group_count = 0;
+
+    bool reap();
+};
+
+}  // namespace journal
@@ -1,3 +1,4 @@
+#include "order_flow.hpp"
 #include "orderbook.hpp"
 
 int main() {
@@ -51,7 +52,7 @@ int main() {
     // Performance test
     std::cout << "\n--- Performance Benchmark ---" << std::endl;
     ob.clear();
-    ob.benchmark(100000);
+    run_flow_benchmark(ob, 100000);
     std::cout << "Final active orders: " << ob.total_orders() << std::endl;
     std::cout << "Total trades executed: " << ob.get_trades().size() << std::endl;
     
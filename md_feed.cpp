@@ -0,0 +1,258 @@
+#include "md_feed.hpp"
+#include "protocol.hpp"
+#include <arpa/inet.h>
+#include <cstring>
+#include <sys/socket.h>
+#include <unistd.h>
+
+using proto::load;
+using proto::store;
+
+namespace md {
+
+void encode_header(uint8_t* p, uint64_t seq, uint16_t msg_count) {
+    std::memset(p, 0, HEADER_SIZE);
+    store<uint64_t>(p, seq);
+    store<uint16_t>(p + 8, msg_count);
+}
+
+}  // namespace md
+
+namespace {
+bool multicast_addr(const char* group, uint16_t port, sockaddr_in& addr) {
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    return inet_pton(AF_INET, group, &addr.sin_addr) == 1;
+}
+}  // namespace
+
+// ---------------- MdPublisher ----------------
+
+MdPublisher::MdPublisher() : buf(BATCH * md::MAX_DATAGRAM) {}
+
+MdPublisher::~MdPublisher() { close(); }
+
+void MdPublisher::close() {
+    if (fd >= 0) ::close(fd);
+    fd = -1;
+}
+
+bool MdPublisher::open(const char* group, uint16_t port, const char* iface) {
+    close();
+    fd = socket(AF_INET, SOCK_DGRAM, 0);
+    if (fd < 0) return false;
+
+    in_addr local{};
+    unsigned char loop = 1, ttl = 1;
+    if (!multicast_addr(group, port, dest) ||
+        inet_pton(AF_INET, iface, &local) != 1 ||
+        setsockopt(fd, IPPROTO_IP, IP_MULTICAST_IF, &local, sizeof(local)) < 0 ||
+        setsockopt(fd, IPPROTO_IP, IP_MULTICAST_LOOP, &loop, sizeof(loop)) < 0 ||
+        setsockopt(fd, IPPROTO_IP, IP_MULTICAST_TTL, &ttl, sizeof(ttl)) < 0) {
+        close();
+        return false;
+    }
+    return true;
+}
+
+// Room for n message bytes in the open datagram, sealing it (and sending the
+// batch once every slot is used) when the message would not fit
+uint8_t* MdPublisher::reserve(size_t n) {
+    if (cur_len + n > md::MAX_DATAGRAM) {
+        seal();
+        if (sealed == BATCH) flush();
+    }
+    if (cur_len == 0) cur_len = md::HEADER_SIZE;
+    uint8_t* p = buf.data() + sealed * md::MAX_DATAGRAM + cur_len;
+    cur_len += n;
+    ++cur_count;
+    return p;
+}
+
+void MdPublisher::seal() {
+    if (cur_count == 0) return;
+    md::encode_header(buf.data() + sealed * md::MAX_DATAGRAM, next_seq++, cur_count);
+    lengths[sealed++] = cur_len;
+    cur_len = 0;
+    cur_count = 0;
+}
+
+void MdPublisher::on_trade(const Trade& trade) {
+    uint8_t* p = reserve(md::TRADE_SIZE);
+    std::memset(p, 0, md::TRADE_SIZE);
+    p[0] = static_cast<uint8_t>(md::MsgType::Trade);
+    store<int32_t>(p + 4, trade.qty);
+    store<uint64_t>(p + 8, trade.buyer_id);
+    store<uint64_t>(p + 16, trade.seller_id);
+    store<double>(p + 24, trade.price);
+}
+
+void MdPublisher::on_level(bool is_bid, const LevelInfo& level) {
+    uint8_t* p = reserve(md::LEVEL_SIZE);
+    std::memset(p, 0, md::LEVEL_SIZE);
+    p[0] = static_cast<uint8_t>(md::MsgType::Level);
+    p[1] = is_bid ? 1 : 0;
+    store<uint32_t>(p + 4, level.count);
+    store<double>(p + 8, level.price);
+    store<int64_t>(p + 16, level.qty);
+}
+
+void MdPublisher::snapshot_begin() {
+    uint8_t* p = reserve(md::SNAPSHOT_SIZE);
+    std::memset(p, 0, md::SNAPSHOT_SIZE);
+    p[0] = static_cast<uint8_t>(md::MsgType::Snapshot);
+}
+
+size_t MdPublisher::flush() {
+    seal();
+    const size_t n = sealed;
+    sealed = 0;
+    if (n == 0) return 0;
+
+    // Closed: the datagrams are lost, receivers will see the sequence jump
+    if (fd < 0) return 0;
+
+    iovec iov[BATCH];
+    mmsghdr msgs[BATCH];
+    std::memset(msgs, 0, sizeof(msgs));
+    for (size_t i = 0; i < n; ++i) {
+        iov[i].iov_base = buf.data() + i * md::MAX_DATAGRAM;
+        iov[i].iov_len = lengths[i];
+        msgs[i].msg_hdr.msg_name = &dest;
+        msgs[i].msg_hdr.msg_namelen = sizeof(dest);
+        msgs[i].msg_hdr.msg_iov = &iov[i];
+        msgs[i].msg_hdr.msg_iovlen = 1;
+    }
+    size_t done = 0;
+    while (done < n) {
+        int r = sendmmsg(fd, msgs + done, static_cast<unsigned>(n - done), 0);
+        ++calls;
+        if (r <= 0) break;  // UDP is lossy anyway; receivers see the gap
+        done += static_cast<size_t>(r);
+    }
+    sent += done;
+    return done;
+}
+
+// ---------------- MdReceiver ----------------
+
+MdReceiver::~MdReceiver() { close(); }
+
+void MdReceiver::close() {
+    if (fd >= 0) ::close(fd);
+    fd = -1;
+}
+
+bool MdReceiver::open(const char* group, uint16_t port, const char* iface) {
+    close();
+    fd = socket(AF_INET, SOCK_DGRAM, 0);
+    if (fd < 0) return false;
+
+    int reuse = 1;
+    int rcvbuf = 4 << 20;
+    sockaddr_in addr{};
+    ip_mreq mreq{};
+    bool ok = setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse)) == 0 &&
+              multicast_addr(group, port, addr) &&
+              bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0 &&
+              inet_pton(AF_INET, iface, &mreq.imr_interface) == 1;
+    if (ok) {
+        mreq.imr_multiaddr = addr.sin_addr;
+        ok = setsockopt(fd, IPPROTO_IP, IP_ADD_MEMBERSHIP, &mreq, sizeof(mreq)) == 0;
+    }
+    if (!ok) {
+        close();
+        return false;
+    }
+    setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(rcvbuf));  // best effort
+    rx.resize(BATCH * md::MAX_DATAGRAM);
+    return true;
+}
+
+size_t MdReceiver::poll() {
+    if (fd < 0) return 0;
+    iovec iov[BATCH];
+    mmsghdr msgs[BATCH];
+    size_t total = 0;
+    for (;;) {
+        std::memset(msgs, 0, sizeof(msgs));
+        for (size_t i = 0; i < BATCH; ++i) {
+            iov[i].iov_base = rx.data() + i * md::MAX_DATAGRAM;
+            iov[i].iov_len = md::MAX_DATAGRAM;
+            msgs[i].msg_hdr.msg_iov = &iov[i];
+            msgs[i].msg_hdr.msg_iovlen = 1;
+        }
+        int r = recvmmsg(fd, msgs, BATCH, MSG_DONTWAIT, nullptr);
+        if (r <= 0) break;
+        for (int i = 0; i < r; ++i) on_datagram(rx.data() + i * md::MAX_DATAGRAM, msgs[i].msg_len);
+        total += static_cast<size_t>(r);
+    }
+    return total;
+}
+
+void MdReceiver::reset_book() {
+    bid_levels.clear();
+    ask_levels.clear();
+}
+
+void MdReceiver::on_datagram(const uint8_t* data, size_t len) {
+    if (len < md::HEADER_SIZE) return;
+    const uint64_t seq = load<uint64_t>(data);
+    const uint16_t count = load<uint16_t>(data + 8);
+
+    if (next_seq == 0) {
+        // Joining mid-stream: nothing before this datagram was seen
+        is_synced = seq == 1;
+    } else if (seq < next_seq) {
+        return;  // duplicate or reordered late arrival
+    } else if (seq > next_seq) {
+        ++gap_count;
+        is_synced = false;
+        reset_book();
+    }
+    next_seq = seq + 1;
+
+    const uint8_t* p = data + md::HEADER_SIZE;
+    const uint8_t* end = data + len;
+    for (uint16_t i = 0; i < count; ++i) {
+        if (p >= end) return;
+        switch (static_cast<md::MsgType>(p[0])) {
+            case md::MsgType::Snapshot:
+                if (end - p < static_cast<ptrdiff_t>(md::SNAPSHOT_SIZE)) return;
+                reset_book();
+                is_synced = true;
+                p += md::SNAPSHOT_SIZE;
+                break;
+            case md::MsgType::Level: {
+                if (end - p < static_cast<ptrdiff_t>(md::LEVEL_SIZE)) return;
+                if (is_synced) {
+                    LevelInfo level;
+                    level.count = load<uint32_t>(p + 4);
+                    level.price = load<double>(p + 8);
+                    level.qty = load<int64_t>(p + 16);
+                    if (p[1] != 0) {
+                        if (level.qty == 0) bid_levels.erase(level.price);
+                        else bid_levels[level.price] = level;
+                    } else {
+                        if (level.qty == 0) ask_levels.erase(level.price);
+                        else ask_levels[level.price] = level;
+                    }
+                }
+                p += md::LEVEL_SIZE;
+                break;
+            }
+            case md::MsgType::Trade:
+                if (end - p < static_cast<ptrdiff_t>(md::TRADE_SIZE)) return;
+                ++trade_count;
+                if (on_trade) {
+                    on_trade(load<uint64_t>(p + 8), load<uint64_t>(p + 16),
+                             load<double>(p + 24), load<int32_t>(p + 4));
+                }
+                p += md::TRADE_SIZE;
+                break;
+            default:
+                return;  // unknown message: sizes are implied by type
+        }
+    }
+}
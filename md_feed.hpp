@@ -0,0 +1,149 @@
+#pragma once
+#include "book_events.hpp"
+#include "orderbook.hpp"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <netinet/in.h>
+#include <vector>
+
+// Sequenced UDP multicast market data.
+//
+// Each datagram carries a 16-byte header (uint64 sequence number, uint16
+// message count) followed by fixed-size little-endian messages:
+//
+//   Level     24B  type 'L', side u8 @1, count u32 @4, price f64 @8, qty i64 @16
+//   Trade     32B  type 'T', qty i32 @4, buyer u64 @8, seller u64 @16, price f64 @24
+//   Snapshot   8B  type 'S': receiver clears its book; Level messages follow
+//
+// Sequence numbers are per datagram and start at 1, so a receiver detects
+// loss as a jump and resynchronizes on the next snapshot.
+namespace md {
+
+constexpr size_t HEADER_SIZE = 16;
+constexpr size_t LEVEL_SIZE = 24;
+constexpr size_t TRADE_SIZE = 32;
+constexpr size_t SNAPSHOT_SIZE = 8;
+constexpr size_t MAX_DATAGRAM = 1400;  // fits a 1500-byte Ethernet MTU
+
+enum class MsgType : uint8_t {
+    Level = 'L',
+    Trade = 'T',
+    Snapshot = 'S',
+};
+
+void encode_header(uint8_t* p, uint64_t seq, uint16_t msg_count);
+
+}  // namespace md
+
+// Publishes book events (as a BookListener) into MTU-sized datagrams and
+// sends every sealed datagram with one sendmmsg() call on flush(). Call
+// flush() after each command or batch of commands.
+class MdPublisher : public BookListener {
+public:
+    static constexpr size_t BATCH = 32;  // datagrams per sendmmsg
+
+    MdPublisher();
+    ~MdPublisher() override;
+    MdPublisher(const MdPublisher&) = delete;
+    MdPublisher& operator=(const MdPublisher&) = delete;
+
+    // Multicast destination; iface selects the outgoing interface and the
+    // feed loops back to local receivers. Returns false on socket errors.
+    bool open(const char* group, uint16_t port, const char* iface = "127.0.0.1");
+    // While closed, datagrams are still sequenced but dropped
+    void close();
+
+    void on_trade(const Trade& trade) override;
+    void on_level(bool is_bid, const LevelInfo& level) override;
+
+    // Full-depth refresh for late joiners and receivers recovering from a
+    // gap. max_levels caps the levels sent per side; by default every level
+    template <class Book>
+    void publish_snapshot(const Book& book, size_t max_levels = SIZE_MAX);
+
+    // Sends all pending datagrams; returns how many were sent
+    size_t flush();
+
+    uint64_t datagrams_sent() const { return sent; }
+    uint64_t send_calls() const { return calls; }
+    uint64_t next_sequence() const { return next_seq; }
+
+private:
+    int fd = -1;
+    sockaddr_in dest{};
+    std::vector<uint8_t> buf;        // BATCH slots of MAX_DATAGRAM bytes
+    size_t lengths[BATCH] = {};
+    size_t sealed = 0;               // complete datagrams waiting to be sent
+    size_t cur_len = 0;              // bytes in the open datagram (slot `sealed`)
+    uint16_t cur_count = 0;
+    uint64_t next_seq = 1;
+    uint64_t sent = 0, calls = 0;
+    std::vector<LevelInfo> snapshot_levels;
+
+    uint8_t* reserve(size_t n);
+    void seal();
+    void snapshot_begin();
+};
+
+template <class Book>
+void MdPublisher::publish_snapshot(const Book& book, size_t max_levels) {
+    snapshot_begin();
+    for (bool is_bid : {true, false}) {
+        // Grow the scratch until depth() leaves room to spare: the whole side
+        size_t n;
+        for (;;) {
+            if (snapshot_levels.size() < 64) snapshot_levels.resize(64);
+            const size_t room = std::min(max_levels, snapshot_levels.size());
+            n = book.depth(is_bid, snapshot_levels.data(), room);
+            if (n < room || room == max_levels) break;
+            snapshot_levels.resize(snapshot_levels.size() * 2);
+        }
+        for (size_t i = 0; i < n; ++i) on_level(is_bid, snapshot_levels[i]);
+    }
+    flush();
+}
+
+// Joins a market-data group and rebuilds the L2 book from the feed
+class MdReceiver {
+public:
+    static constexpr size_t BATCH = 32;  // datagrams per recvmmsg
+
+    MdReceiver() = default;
+    ~MdReceiver();
+    MdReceiver(const MdReceiver&) = delete;
+    MdReceiver& operator=(const MdReceiver&) = delete;
+
+    bool open(const char* group, uint16_t port, const char* iface = "127.0.0.1");
+    void close();
+    // Drains datagrams already queued on the socket without blocking
+    size_t poll();
+    // Applies one datagram (exposed so feeds can be replayed without sockets)
+    void on_datagram(const uint8_t* data, size_t len);
+
+    // False from a gap until the next snapshot; levels are not trustworthy
+    bool synced() const { return is_synced; }
+    uint64_t gaps() const { return gap_count; }
+    uint64_t trades() const { return trade_count; }
+    uint64_t expected_sequence() const { return next_seq; }
+
+    const std::map<double, LevelInfo, std::greater<>>& bids() const { return bid_levels; }
+    const std::map<double, LevelInfo>& asks() const { return ask_levels; }
+
+    // Optional per-trade callback
+    std::function<void(uint64_t buyer, uint64_t seller, double price, int32_t qty)> on_trade;
+
+private:
+    int fd = -1;
+    uint64_t next_seq = 0;  // 0 until the first datagram
+    bool is_synced = false;
+    uint64_t gap_count = 0;
+    uint64_t trade_count = 0;
+    std::map<double, LevelInfo, std::greater<>> bid_levels;
+    std::map<double, LevelInfo> ask_levels;
+    std::vector<uint8_t> rx;
+
+    void reset_book();
+};
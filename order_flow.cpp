@@ -0,0 +1,225 @@
+#include "order_flow.hpp"
+#include "protocol.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+
+namespace {
+// Aggressors are sized a little above the average resting order
+constexpr double AGGRESSOR_LOTS = 1.5;
+// Events over which the controller works off a cancel/trade deficit
+constexpr double CORRECTION_EVENTS = 20000.0;
+}
+
+OrderFlowGenerator::OrderFlowGenerator(const FlowConfig& config)
+    : cfg(config), rng(config.seed) {
+    update_mix();
+}
+
+// Steady state per event: passive adds balance cancels plus fills, and
+// cancels are cancel_to_trade (R) times the fills. With aggressor share a,
+// f fills per aggressor and s sweep fills per event:
+//   adds = 1 - modify - a - c = c + f a + s   and   c = R (f a + s)
+//   =>  a = (1 - modify - s (1 + 2R)) / (1 + f + 2 R f)
+// f and s start from estimates and are refined from the shadow book's fills.
+void OrderFlowGenerator::update_mix() {
+    const double r = cfg.cancel_to_trade;
+    const double f = fills_per_aggressor;
+    const double s = sweep_fills_per_event;
+    p_aggressive = std::max(0.0, (1.0 - cfg.modify_fraction - s * (1.0 + 2.0 * r)) / (1.0 + f + 2.0 * r * f));
+    p_cancel = r * (f * p_aggressive + s);
+}
+
+double OrderFlowGenerator::uniform() {
+    return static_cast<double>(rng() >> 11) * 0x1.0p-53;
+}
+
+int OrderFlowGenerator::lots() {
+    return cfg.lot * (1 + static_cast<int>(uniform() * cfg.max_lots));
+}
+
+// Lomax (shifted Pareto): P(d >= k) = (1 + k / scale)^-alpha, so most
+// orders sit within a few ticks of the touch and a heavy tail fills out the
+// deep book
+int64_t OrderFlowGenerator::distance() {
+    double u = 1.0 - uniform();  // (0, 1]
+    double d = cfg.distance_scale * (std::pow(u, -1.0 / cfg.distance_alpha) - 1.0);
+    return std::min<int64_t>(static_cast<int64_t>(d), cfg.max_distance);
+}
+
+int64_t OrderFlowGenerator::touch(bool is_bid) const {
+    LevelInfo top;
+    if (shadow.depth(is_bid, &top, 1) == 0) return 0;
+    return std::llround(top.price / cfg.tick);
+}
+
+double OrderFlowGenerator::passive_price(bool is_bid) {
+    const int64_t bid = touch(true), ask = touch(false);
+    const int64_t mid = std::llround(cfg.mid / cfg.tick);
+    int64_t ticks;
+    if (bid != 0 && ask != 0 && ask - bid > 1 && uniform() < cfg.improve_fraction) {
+        ticks = is_bid ? bid + 1 : ask - 1;  // step inside a wide spread
+    } else if (is_bid) {
+        ticks = (bid != 0 ? bid : (ask != 0 ? ask - 1 : mid - 1)) - distance();
+    } else {
+        ticks = (ask != 0 ? ask : (bid != 0 ? bid + 1 : mid + 1)) + distance();
+    }
+    // Never cross: passive orders stay behind the opposite touch
+    if (is_bid && ask != 0) ticks = std::min(ticks, ask - 1);
+    if (!is_bid && bid != 0) ticks = std::max(ticks, bid + 1);
+    return static_cast<double>(ticks) * cfg.tick;
+}
+
+// Index of a random live order; entries filled since they were added are
+// dropped on the way
+bool OrderFlowGenerator::pick_live(size_t& index) {
+    while (!live.empty()) {
+        index = static_cast<size_t>(uniform() * static_cast<double>(live.size()));
+        if (shadow.contains(live[index].id)) return true;
+        live[index] = live.back();
+        live.pop_back();
+    }
+    return false;
+}
+
+void OrderFlowGenerator::aggressive(bool is_bid, int qty) {
+    ev.is_bid = is_bid;
+    ev.qty = qty;
+    if (uniform() < cfg.market_fraction) {
+        ev.type = FlowEvent::Type::Market;
+        ev.price = 0.0;
+        ev.order_id = shadow.add_market(qty, is_bid);
+        return;
+    }
+    // Marketable limit a few ticks through the opposite touch; any
+    // remainder rests and becomes the new touch
+    ev.type = FlowEvent::Type::Limit;
+    int64_t opposite = touch(!is_bid);
+    if (opposite == 0) opposite = touch(is_bid);
+    if (opposite == 0) opposite = std::llround(cfg.mid / cfg.tick);
+    int64_t through = static_cast<int64_t>(uniform() * 3);
+    ev.price = static_cast<double>(opposite + (is_bid ? through : -through)) * cfg.tick;
+    ev.order_id = shadow.add_limit(ev.price, qty, is_bid, ev.owner);
+    live.push_back({ev.order_id, is_bid});
+}
+
+void OrderFlowGenerator::passive() {
+    ev.type = FlowEvent::Type::Limit;
+    ev.is_bid = uniform() < 0.5;
+    ev.qty = lots();
+    ev.price = passive_price(ev.is_bid);
+    ev.order_id = shadow.add_limit(ev.price, ev.qty, ev.is_bid, ev.owner);
+    live.push_back({ev.order_id, ev.is_bid});
+}
+
+const FlowEvent& OrderFlowGenerator::next() {
+    ++n_events;
+    ev.owner = static_cast<uint32_t>(uniform() * cfg.owners);
+
+    // Inter-arrival times are exponential; sweeps arrive much faster
+    double rate = cfg.events_per_sec * (burst_left > 0 ? cfg.burst_speedup : 1.0);
+    now_ns += -std::log(1.0 - uniform()) / rate * 1e9;
+    ev.ts_ns = static_cast<int64_t>(now_ns);
+
+    if (n_events <= cfg.initial_orders) {
+        passive();
+        return ev;
+    }
+    if (burst_left == 0 && uniform() < cfg.burst_probability) {
+        burst_left = cfg.burst_length;
+        burst_is_bid = uniform() < 0.5;
+        ++n_sweeps;
+    }
+    if (burst_left > 0) {
+        // Each sweep order takes out the whole opposite touch and then some
+        --burst_left;
+        LevelInfo top;
+        int64_t level_qty = shadow.depth(!burst_is_bid, &top, 1) ? top.qty : 0;
+        const uint64_t before = trades();
+        aggressive(burst_is_bid, static_cast<int>(std::min<int64_t>(level_qty + lots(), 1 << 30)));
+        sweep_fills += trades() - before;
+        return ev;
+    }
+
+    // Each resting order carries a cancel hazard, so the cancel share scales
+    // with depth and holds the book near initial_orders. The aggressor share
+    // is the steady-state mix plus a term proportional to the fill deficit,
+    // which is paid off over about CORRECTION_EVENTS events.
+    if (n_events % 1024 == 0) {
+        if (n_aggressors > 0) {
+            fills_per_aggressor = static_cast<double>(aggressor_fills) / static_cast<double>(n_aggressors);
+        }
+        sweep_fills_per_event = static_cast<double>(sweep_fills) / static_cast<double>(n_events - cfg.initial_orders);
+        update_mix();
+    }
+    const double depth = static_cast<double>(shadow.total_orders()) /
+                         static_cast<double>(std::max<size_t>(cfg.initial_orders, 1));
+    const double c = p_cancel * std::min(depth, 1.5);
+    const double deficit = static_cast<double>(n_cancels) / cfg.cancel_to_trade - static_cast<double>(trades());
+    const double a = std::clamp(p_aggressive + deficit / (fills_per_aggressor * CORRECTION_EVENTS), 0.0,
+                                4.0 * p_aggressive + 1e-3);
+
+    const double u = uniform();
+    size_t i = 0;
+    if (u < a) {
+        const uint64_t before = trades();
+        aggressive(uniform() < 0.5, static_cast<int>(AGGRESSOR_LOTS * cfg.lot * (1 + cfg.max_lots) / 2));
+        aggressor_fills += trades() - before;
+        ++n_aggressors;
+    } else if (u < a + cfg.modify_fraction && pick_live(i)) {
+        // Reprice and resize on the same side, keeping the id
+        ev.type = FlowEvent::Type::Modify;
+        ev.order_id = live[i].id;
+        ev.is_bid = live[i].is_bid;
+        ev.qty = lots();
+        ev.price = passive_price(ev.is_bid);
+        shadow.modify(ev.order_id, ev.price, ev.qty);
+    } else if (u < a + cfg.modify_fraction + c && pick_live(i)) {
+        ev.type = FlowEvent::Type::Cancel;
+        ev.order_id = live[i].id;
+        ev.is_bid = live[i].is_bid;
+        live[i] = live.back();
+        live.pop_back();
+        shadow.cancel(ev.order_id);
+        ++n_cancels;
+    } else {
+        passive();
+    }
+    return ev;
+}
+
+size_t OrderFlowGenerator::encode(const FlowEvent& e, uint8_t* out) {
+    switch (e.type) {
+        case FlowEvent::Type::Limit: return proto::encode_new_order(out, e.is_bid, e.price, e.qty, e.owner);
+        case FlowEvent::Type::Market: return proto::encode_market(out, e.is_bid, e.qty);
+        case FlowEvent::Type::Cancel: return proto::encode_cancel(out, e.order_id);
+        case FlowEvent::Type::Modify: return proto::encode_modify(out, e.order_id, e.price, e.qty);
+    }
+    return 0;
+}
+
+void OrderFlowGenerator::record(size_t n, cmdlog::Writer& writer) {
+    uint8_t msg[proto::NEW_ORDER_SIZE];
+    for (size_t i = 0; i < n; ++i) {
+        const FlowEvent& e = next();
+        encode(e, msg);
+        writer.append(e.ts_ns, msg);
+    }
+}
+
+void run_flow_benchmark(OrderBook& book, int n) {
+    OrderFlowGenerator gen;
+    std::vector<FlowEvent> events(static_cast<size_t>(std::max(n, 0)));
+    for (auto& e : events) e = gen.next();
+    // Event targets count from 1; shift them past ids the book already issued
+    const uint64_t id_base = book.next_order_id() - 1;
+
+    auto start = std::chrono::high_resolution_clock::now();
+    for (const auto& e : events) apply_flow(book, e, id_base);
+    auto end = std::chrono::high_resolution_clock::now();
+    std::cout << "Processed " << n << " synthetic events (" << gen.cancels() << " cancels, "
+              << gen.trades() << " trades) in "
+              << std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count() / 1e6
+              << " ms\n";
+}
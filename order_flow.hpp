@@ -0,0 +1,123 @@
+#pragma once
+#include "command_log.hpp"
+#include "orderbook.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+// Seeded synthetic order flow with production-like structure.
+//
+// Events arrive as a Poisson process. Passive orders rest at a power-law
+// distance (in ticks) behind the touch of their side, about cancel_to_trade
+// orders are cancelled for every trade, and occasional sweeps fire a fast
+// burst of aggressive orders on one side that walks the price.
+//
+// The aggressor share is set from the measured fills per aggressor and per
+// sweep, plus a correction proportional to the fill deficit. A sweep fills
+// about a thousand orders at once. At most about half the events can be
+// cancels, so the ratio dips after a sweep for roughly 2 * cancel_to_trade
+// times that many events. It holds over long runs.
+//
+// The generator matches every event against its own shadow OrderBook, so it
+// knows the touch, the ids a fresh book will assign and which orders are
+// still live: every cancel and modify it emits is accepted when the stream
+// is applied in order to an empty book. The same seed always yields the
+// same sequence.
+struct FlowConfig {
+    uint64_t seed = 1;
+    double mid = 100.0;              // initial price when the book is empty
+    double tick = 0.01;
+    double events_per_sec = 1e6;     // mean Poisson arrival rate
+    double distance_alpha = 1.3;     // tail exponent of distance from touch
+    double distance_scale = 10.0;    // ticks; larger spreads orders deeper
+    int max_distance = 1000;         // ticks
+    double cancel_to_trade = 30.0;   // cancels per trade
+    double modify_fraction = 0.05;   // share of events that modify
+    double market_fraction = 0.3;    // share of aggressors sent as market orders
+    double improve_fraction = 0.2;   // passive orders that narrow a wide spread
+    int lot = 10;
+    int max_lots = 20;               // passive quantity is 1..max_lots lots
+    double burst_probability = 1e-5; // chance per event that a sweep starts
+    int burst_length = 5;            // aggressive orders per sweep, each clearing a level
+    double burst_speedup = 50.0;     // arrival rate multiplier inside a sweep
+    uint32_t owners = 64;
+    size_t initial_orders = 5000;    // passive-only warm-up building depth
+};
+
+struct FlowEvent {
+    enum class Type : uint8_t { Limit, Cancel, Modify, Market };
+    Type type = Type::Limit;
+    bool is_bid = false;
+    int32_t qty = 0;
+    uint32_t owner = 0;
+    double price = 0.0;
+    uint64_t order_id = 0;  // id the book assigns, or the target id
+    int64_t ts_ns = 0;
+};
+
+class OrderFlowGenerator {
+public:
+    explicit OrderFlowGenerator(const FlowConfig& config = {});
+
+    const FlowEvent& next();
+
+    // Encodes an event as an order-entry message; returns its size
+    static size_t encode(const FlowEvent& event, uint8_t* out);
+    // Appends n events to a command log
+    void record(size_t n, cmdlog::Writer& writer);
+
+    uint64_t events() const { return n_events; }
+    uint64_t cancels() const { return n_cancels; }
+    uint64_t trades() const { return shadow.analytics().trades(); }
+    uint64_t sweeps() const { return n_sweeps; }
+    const OrderBook& book() const { return shadow; }
+
+private:
+    struct Live {
+        uint64_t id;
+        bool is_bid;
+    };
+
+    FlowConfig cfg;
+    std::mt19937_64 rng;
+    OrderBook shadow;
+    FlowEvent ev;
+    double now_ns = 0.0;
+    std::vector<Live> live;  // may hold filled orders; pruned when picked
+    int burst_left = 0;
+    bool burst_is_bid = false;
+    uint64_t n_events = 0, n_cancels = 0, n_sweeps = 0;
+    uint64_t n_aggressors = 0, aggressor_fills = 0, sweep_fills = 0;
+    double fills_per_aggressor = 2.0;    // refined as the flow runs
+    double sweep_fills_per_event = 0.0;
+    double p_aggressive = 0.0, p_cancel = 0.0;  // steady-state event shares
+
+    void update_mix();  // recomputes the event shares
+    double uniform();   // [0, 1)
+    int lots();
+    int64_t distance();
+    int64_t touch(bool is_bid) const;  // in ticks, 0 if the side is empty
+    double passive_price(bool is_bid);
+    bool pick_live(size_t& index);
+    void aggressive(bool is_bid, int qty);
+    void passive();
+};
+
+// Applies one event to a book; returns the id on an accepted order,
+// 1/0 for accepted/rejected cancels and modifies. id_base shifts target ids
+// for a book that had already assigned id_base ids when the stream began.
+template <class Book>
+uint64_t apply_flow(Book& book, const FlowEvent& e, uint64_t id_base = 0) {
+    switch (e.type) {
+        case FlowEvent::Type::Limit: return book.add_limit(e.price, e.qty, e.is_bid, e.owner);
+        case FlowEvent::Type::Market: return book.add_market(e.qty, e.is_bid);
+        case FlowEvent::Type::Cancel: return book.cancel(e.order_id + id_base) ? 1 : 0;
+        case FlowEvent::Type::Modify: return book.modify(e.order_id + id_base, e.price, e.qty) ? 1 : 0;
+    }
+    return 0;
+}
+
+// Times n events of the default synthetic flow against the book and prints
+// the result. Events are generated up front, so only the book is timed.
+void run_flow_benchmark(OrderBook& book, int n);
@@ -0,0 +1,97 @@
+#include "order_index.hpp"
+#include <algorithm>
+#include <iterator>
+
+namespace {
+// Spares kept beyond this are freed, bounding memory after a burst
+constexpr size_t MAX_SPARE_PAGES = 64;
+}
+
+OrderIndex::OrderIndex(size_t spare_pages) {
+    for (size_t i = 0; i < spare_pages; ++i) spare.push_back(std::make_unique<Page>());
+}
+
+std::unique_ptr<OrderIndex::Page> OrderIndex::acquire_page() {
+    std::unique_ptr<Page> page;
+    if (!spare.empty()) {
+        page = std::move(spare.back());
+        spare.pop_back();
+    } else {
+        page = std::make_unique<Page>();
+    }
+    std::fill(std::begin(page->slots), std::end(page->slots), NIL_ORDER);
+    page->live = 0;
+    return page;
+}
+
+void OrderIndex::insert(uint64_t id, OrderHandle h) {
+    uint64_t page = id >> PAGE_BITS;
+    if (pages.empty()) {
+        base_page = page;
+        leading_empty = 0;
+    } else if (page < base_page) {
+        // Re-inserting an id older than the window (rare): grow it backwards
+        size_t grow = static_cast<size_t>(base_page - page);
+        std::vector<std::unique_ptr<Page>> front(grow);
+        pages.insert(pages.begin(), std::make_move_iterator(front.begin()),
+                     std::make_move_iterator(front.end()));
+        base_page = page;
+        leading_empty += grow;
+    }
+    size_t slot = static_cast<size_t>(page - base_page);
+    if (slot >= pages.size()) pages.resize(slot + 1);
+
+    std::unique_ptr<Page>& p = pages[slot];
+    if (!p) {
+        p = acquire_page();
+        if (slot < leading_empty) leading_empty = slot;
+    }
+    OrderHandle& entry = p->slots[id & (PAGE_SIZE - 1)];
+    if (entry == NIL_ORDER) {
+        ++p->live;
+        ++live;
+    }
+    entry = h;
+}
+
+bool OrderIndex::erase(uint64_t id) {
+    uint64_t page = id >> PAGE_BITS;
+    if (page < base_page || page - base_page >= pages.size()) return false;
+    size_t slot = static_cast<size_t>(page - base_page);
+    Page* p = pages[slot].get();
+    if (!p) return false;
+    OrderHandle& entry = p->slots[id & (PAGE_SIZE - 1)];
+    if (entry == NIL_ORDER) return false;
+    entry = NIL_ORDER;
+    --live;
+    if (--p->live == 0) release_page(slot);
+    return true;
+}
+
+void OrderIndex::release_page(size_t slot) {
+    if (spare.size() < MAX_SPARE_PAGES) spare.push_back(std::move(pages[slot]));
+    else pages[slot].reset();
+
+    // Slide the window past the empty prefix once it is worth the move
+    if (slot == leading_empty) {
+        while (leading_empty < pages.size() && !pages[leading_empty]) ++leading_empty;
+    }
+    if (leading_empty == pages.size()) {
+        pages.clear();
+        leading_empty = 0;
+    } else if (leading_empty >= 64 && leading_empty * 2 >= pages.size()) {
+        pages.erase(pages.begin(), pages.begin() + static_cast<std::ptrdiff_t>(leading_empty));
+        base_page += leading_empty;
+        leading_empty = 0;
+    }
+}
+
+void OrderIndex::clear() {
+    for (auto& p : pages) {
+        if (p && spare.size() < MAX_SPARE_PAGES) spare.push_back(std::move(p));
+    }
+    pages.clear();
+    base_page = 0;
+    leading_empty = 0;
+    live = 0;
+}
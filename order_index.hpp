@@ -0,0 +1,52 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// Index of an order slot in the book's order pool
+using OrderHandle = uint32_t;
+constexpr OrderHandle NIL_ORDER = UINT32_MAX;
+
+// id → pool handle for the book's sequential order ids.
+//
+// A direct-mapped paged array: id >> PAGE_BITS selects a page from a sliding
+// window, the low bits select the slot, so a lookup is one load from the
+// (hot) page table plus one from the page. Pages whose orders are all gone
+// are recycled through a spare list and the window slides forward, so inserts
+// and erases do not allocate once the live id range stops growing.
+class OrderIndex {
+public:
+    static constexpr unsigned PAGE_BITS = 12;
+    static constexpr size_t PAGE_SIZE = size_t(1) << PAGE_BITS;
+
+    explicit OrderIndex(size_t spare_pages = 4);
+
+    OrderHandle find(uint64_t id) const {
+        uint64_t page = id >> PAGE_BITS;
+        if (page < base_page || page - base_page >= pages.size()) return NIL_ORDER;
+        const Page* p = pages[page - base_page].get();
+        return p ? p->slots[id & (PAGE_SIZE - 1)] : NIL_ORDER;
+    }
+    bool contains(uint64_t id) const { return find(id) != NIL_ORDER; }
+
+    void insert(uint64_t id, OrderHandle h);
+    bool erase(uint64_t id);
+    size_t size() const { return live; }
+    void clear();
+
+private:
+    struct Page {
+        OrderHandle slots[PAGE_SIZE];
+        uint32_t live;
+    };
+
+    std::vector<std::unique_ptr<Page>> pages;  // window starting at base_page
+    std::vector<std::unique_ptr<Page>> spare;
+    uint64_t base_page = 0;
+    size_t leading_empty = 0;                  // null pages at the front of the window
+    size_t live = 0;
+
+    std::unique_ptr<Page> acquire_page();
+    void release_page(size_t slot);
+};
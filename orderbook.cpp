@@ -1,138 +1,575 @@
 #include "orderbook.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iterator>
 
-void OrderBook::match(Order& inc, bool is_bid) {
+namespace {
+
+// Checksum event kinds
+enum : uint64_t { EV_REST = 1, EV_TRADE = 2, EV_REMOVE = 3, EV_REDUCE = 4 };
+
+uint64_t price_bits(double price) {
+    uint64_t bits;
+    std::memcpy(&bits, &price, sizeof(bits));
+    return bits;
+}
+
+// One resting order's term in state_hash()
+uint64_t order_key(uint64_t id, bool is_bid, double price, int qty) {
+    uint64_t x = id * 0x9e3779b97f4a7c15ULL ^ price_bits(price) * 0xc2b2ae3d27d4eb4fULL ^
+                 (static_cast<uint64_t>(static_cast<uint32_t>(qty)) << 1 | is_bid);
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+    return x ^ (x >> 31);
+}
+
+}  // namespace
+
+template <class Allocation>
+void BasicOrderBook<Allocation>::LevelView::remove_filled() {
+    for (OrderHandle h = level.head; h != NIL_ORDER;) {
+        OrderHandle next = book.pool[h].next;
+        if (book.pool[h].qty == 0) book.remove_order(h);
+        h = next;
+    }
+}
+
+template <class Allocation>
+int BasicOrderBook<Allocation>::match(uint64_t id, double price, int qty, bool is_bid) {
     if (is_bid) {
         // incoming bid matches against asks (ascending map)
         auto& book = asks;
         auto it = book.begin();
-        while (inc.qty > 0 && it != book.end() && it->first <= inc.price) {
-            auto& level = it->second;
-            while (inc.qty > 0 && !level.empty()) {
-                Order& resting = level.front();
-                int trade_qty = std::min(inc.qty, resting.qty);
-                
-                // Record the trade
-                trades.emplace_back(inc.id, resting.id, it->first, trade_qty);
-                
-                inc.qty -= trade_qty;
-                resting.qty -= trade_qty;
-                
-                if (resting.qty == 0) {
-                    order_index.erase(resting.id);
-                    level.pop_front();  // O(1) with deque
-                }
-            }
-            if (level.empty()) it = book.erase(it);
+        while (qty > 0 && it != book.end() && it->first <= price) {
+            const double level_price = it->first;
+            PriceLevel& level = it->second;
+            LevelView view(*this, level);
+            qty = allocation.allocate(view, qty, [&](Order& resting, int trade_qty) {
+                level.total_qty -= trade_qty;
+                rehash(resting.id, false, level_price, resting.qty + trade_qty, resting.qty);
+                if (level.queue) level.queue->reduce(meta[&resting - pool.data()].queue_slot, trade_qty);
+                record_trade(id, resting.id, level_price, trade_qty);
+            });
+            level_changed(false, level_price, level);
+            if (view.empty()) it = book.erase(it);
             else ++it;
         }
     } else {
         // incoming ask matches against bids (descending map)
         auto& book = bids;
         auto it = book.begin();
-        while (inc.qty > 0 && it != book.end() && it->first >= inc.price) {
-            auto& level = it->second;
-            while (inc.qty > 0 && !level.empty()) {
-                Order& resting = level.front();
-                int trade_qty = std::min(inc.qty, resting.qty);
-                
-                // Record the trade
-                trades.emplace_back(resting.id, inc.id, it->first, trade_qty);
-                
-                inc.qty -= trade_qty;
-                resting.qty -= trade_qty;
-                
-                if (resting.qty == 0) {
-                    order_index.erase(resting.id);
-                    level.pop_front();  // O(1) with deque
-                }
-            }
-            if (level.empty()) it = book.erase(it);
+        while (qty > 0 && it != book.end() && it->first >= price) {
+            const double level_price = it->first;
+            PriceLevel& level = it->second;
+            LevelView view(*this, level);
+            qty = allocation.allocate(view, qty, [&](Order& resting, int trade_qty) {
+                level.total_qty -= trade_qty;
+                rehash(resting.id, true, level_price, resting.qty + trade_qty, resting.qty);
+                if (level.queue) level.queue->reduce(meta[&resting - pool.data()].queue_slot, trade_qty);
+                record_trade(resting.id, id, level_price, trade_qty);
+            });
+            level_changed(true, level_price, level);
+            if (view.empty()) it = book.erase(it);
             else ++it;
         }
     }
+    return qty;
 }
 
-uint64_t OrderBook::add_limit(double price, int qty, bool is_bid) {
-    if (qty <= 0) return 0;
-    Order inc(next_id++, price, qty);
-    uint64_t order_id = inc.id;
+template <class Allocation>
+void BasicOrderBook<Allocation>::rest(uint64_t id, double price, int qty, bool is_bid, uint32_t owner) {
+    OrderHandle h;
+    if (!free_slots.empty()) {
+        h = free_slots.back();
+        free_slots.pop_back();
+        pool[h] = Order(id, qty, owner, stamp());
+        meta[h] = OrderMeta();
+    } else {
+        h = static_cast<OrderHandle>(pool.size());
+        pool.emplace_back(id, qty, owner, stamp());
+        meta.emplace_back();
+    }
+    Order& o = pool[h];
+    OrderMeta& m = meta[h];
+    m.price = price;
+    m.is_bid = is_bid;
+
+    // Append to the level FIFO
+    PriceLevel& level = is_bid ? bids[price] : asks[price];
+    m.level = &level;
+    o.prev = level.tail;
+    if (level.tail != NIL_ORDER) pool[level.tail].next = h;
+    else level.head = h;
+    level.tail = h;
+    ++level.count;
+    level.total_qty += qty;
+    if (level.queue) {
+        if (level.queue->full()) build_queue(level);
+        else m.queue_slot = level.queue->push(qty);
+    }
+    level_changed(is_bid, price, level);
+
+    // Push onto the owner's list
+    OwnerOrders& mine = owners[owner];
+    m.owner_next = mine.head;
+    if (mine.head != NIL_ORDER) meta[mine.head].owner_prev = h;
+    mine.head = h;
+    ++mine.count;
+
+    // Add to index for O(1) cancellation
+    order_index.insert(id, h);
+    fold(EV_REST | static_cast<uint64_t>(is_bid) << 8, id, price_bits(price), static_cast<uint64_t>(qty));
+    live_hash ^= order_key(id, is_bid, price, qty);
+}
+
+// Unlinks an order from its level, owner list and index and frees its slot.
+// Leaves an emptied level in place; callers erase it from the side map.
+template <class Allocation>
+void BasicOrderBook<Allocation>::remove_order(OrderHandle h) {
+    Order& o = pool[h];
+    OrderMeta& m = meta[h];
+
+    PriceLevel& level = *m.level;
+    if (o.prev != NIL_ORDER) pool[o.prev].next = o.next;
+    else level.head = o.next;
+    if (o.next != NIL_ORDER) pool[o.next].prev = o.prev;
+    else level.tail = o.prev;
+    --level.count;
+    level.total_qty -= o.qty;
+    if (level.queue) level.queue->leave(m.queue_slot, o.qty);
+
+    auto owner_it = owners.find(o.owner);
+    OwnerOrders& mine = owner_it->second;
+    if (m.owner_prev != NIL_ORDER) meta[m.owner_prev].owner_next = m.owner_next;
+    else mine.head = m.owner_next;
+    if (m.owner_next != NIL_ORDER) meta[m.owner_next].owner_prev = m.owner_prev;
+    if (--mine.count == 0) owners.erase(owner_it);
+
+    order_index.erase(o.id);
+    fold(EV_REMOVE, o.id, 0, static_cast<uint64_t>(o.qty));
+    live_hash ^= order_key(o.id, m.is_bid, m.price, o.qty);
+    m.level = nullptr;
+    free_slots.push_back(h);
+}
+
+template <class Allocation>
+uint64_t BasicOrderBook<Allocation>::add_limit(double price, int qty, bool is_bid, uint32_t owner) {
+    // A NaN key would compare equivalent to every level and corrupt the maps
+    if (qty <= 0 || !std::isfinite(price)) return 0;
+    uint64_t order_id = next_id++;
     
-    // Attempt to match first; if any quantity remains, insert into the book
-    match(inc, is_bid);
+    // Attempt to match first; if any quantity remains, insert into the book.
+    // During an auction orders accumulate and are only crossed by uncross().
+    if (!in_auction) qty = match(order_id, price, qty, is_bid);
     
-    if (inc.qty > 0) {
-        if (is_bid) {
-            bids[inc.price].push_back(inc);
-        } else {
-            asks[inc.price].push_back(inc);
-        }
-        // Add to index for O(1) cancellation
-        order_index[order_id] = {price, is_bid};
+    if (qty > 0) rest(order_id, price, qty, is_bid, owner);
+    return order_id;
+}
+
+template <class Allocation>
+uint64_t BasicOrderBook<Allocation>::add_limit(double price, int qty, bool is_bid,
+                                               std::chrono::nanoseconds expire_at, uint32_t owner) {
+    if (expire_at <= last_time) return 0;
+    uint64_t order_id = add_limit(price, qty, is_bid, owner);
+    // Only resting orders need a timer; fully filled ones are already gone
+    if (order_id != 0 && order_index.contains(order_id)) expiries.schedule(order_id, expire_at);
+    return order_id;
+}
+
+template <class Allocation>
+size_t BasicOrderBook<Allocation>::advance_time(std::chrono::nanoseconds now) {
+    if (now <= last_time) return 0;
+    last_time = now;
+    expired_scratch.clear();
+    expiries.advance(now, expired_scratch);
+    size_t expired = 0;
+    for (uint64_t id : expired_scratch) {
+        if (cancel(id)) ++expired;
+    }
+    return expired;
+}
+
+template <class Allocation>
+bool BasicOrderBook<Allocation>::cancel(uint64_t id) {
+    // O(1) lookup using order_index, O(1) unlink from the level
+    OrderHandle h = order_index.find(id);
+    if (h == NIL_ORDER) return false;
+
+    const OrderMeta& m = meta[h];
+    const double price = m.price;
+    const bool is_bid = m.is_bid;
+    PriceLevel& level = *m.level;
+    remove_order(h);
+    level_changed(is_bid, price, level);
+    if (level.count == 0) {
+        if (is_bid) bids.erase(price);
+        else asks.erase(price);
+    }
+    return true;
+}
+
+template <class Allocation>
+bool BasicOrderBook<Allocation>::modify(uint64_t id, double price, int qty) {
+    if (!std::isfinite(price)) return false;
+    OrderHandle h = order_index.find(id);
+    if (h == NIL_ORDER) return false;
+    if (qty <= 0) return cancel(id);
+
+    Order& o = pool[h];
+    const OrderMeta& m = meta[h];
+    if (price == m.price && qty <= o.qty) {
+        m.level->total_qty -= o.qty - qty;
+        rehash(id, m.is_bid, price, o.qty, qty);
+        if (m.level->queue) m.level->queue->reduce(m.queue_slot, o.qty - qty);
+        o.qty = qty;
+        fold(EV_REDUCE, id, 0, static_cast<uint64_t>(qty));
+        level_changed(m.is_bid, price, *m.level);
+        return true;
     }
+
+    // Loses priority: re-enter at the back of the (possibly new) level.
+    // A pending GTT timer is keyed by id and still applies.
+    const bool is_bid = m.is_bid;
+    const uint32_t owner = o.owner;
+    cancel(id);
+    if (!in_auction) qty = match(id, price, qty, is_bid);
+    if (qty > 0) rest(id, price, qty, is_bid, owner);
+    return true;
+}
+
+template <class Allocation>
+size_t BasicOrderBook<Allocation>::cancel_all(uint32_t owner) {
+    auto owner_it = owners.find(owner);
+    if (owner_it == owners.end()) return 0;
+
+    // remove_order erases the owner entry with the last order, so walk from a
+    // copy of the head and never touch owner_it afterwards
+    size_t cancelled = 0;
+    mass_update = signal_depth != 0;
+    for (OrderHandle h = owner_it->second.head; h != NIL_ORDER;) {
+        const OrderMeta& m = meta[h];
+        OrderHandle next = m.owner_next;
+        PriceLevel& level = *m.level;
+        const double price = m.price;
+        const bool is_bid = m.is_bid;
+        remove_order(h);
+        level_changed(is_bid, price, level);
+        if (level.count == 0) (is_bid ? emptied_bids : emptied_asks).push_back(price);
+        ++cancelled;
+        h = next;
+    }
+    erase_emptied();
+    if (mass_update) end_mass_update();
+    return cancelled;
+}
+
+template <class Allocation>
+size_t BasicOrderBook<Allocation>::cancel_side(bool is_bid) {
+    size_t cancelled = 0;
+    mass_update = signal_depth != 0;
+    auto drop_all = [&](auto& side) {
+        for (auto& [price, level] : side) {
+            for (OrderHandle h = level.head; h != NIL_ORDER;) {
+                OrderHandle next = pool[h].next;
+                remove_order(h);
+                ++cancelled;
+                h = next;
+            }
+            level_changed(is_bid, price, level);
+        }
+        side.clear();
+    };
+    if (is_bid) drop_all(bids);
+    else drop_all(asks);
+    if (mass_update) end_mass_update();
+    return cancelled;
+}
+
+template <class Allocation>
+void BasicOrderBook<Allocation>::erase_emptied() {
+    for (double price : emptied_bids) bids.erase(price);
+    for (double price : emptied_asks) asks.erase(price);
+    emptied_bids.clear();
+    emptied_asks.clear();
+}
+
+template <class Allocation>
+uint64_t BasicOrderBook<Allocation>::add_market(int qty, bool is_bid) {
+    if (qty <= 0 || in_auction) return 0;
+    uint64_t order_id = next_id++;
+    match(order_id, is_bid ? 1e9 : 0.0, qty, is_bid);  // Extreme price to match any available
     return order_id;
 }
 
-bool OrderBook::cancel(uint64_t id) {
-    // O(1) lookup using order_index
-    auto it = order_index.find(id);
-    if (it == order_index.end()) return false;
-    
-    auto [price, is_bid] = it->second;
-    
-    if (is_bid) {
-        auto level_it = bids.find(price);
-        if (level_it != bids.end()) {
-            auto& level = level_it->second;
-            for (auto order_it = level.begin(); order_it != level.end(); ++order_it) {
-                if (order_it->id == id) {
-                    level.erase(order_it);
-                    if (level.empty()) bids.erase(level_it);
-                    order_index.erase(it);
-                    return true;
-                }
+template <class Allocation>
+AuctionResult BasicOrderBook<Allocation>::indicative_uncross() const {
+    AuctionResult best;
+    if (bids.empty() || asks.empty() || bids.begin()->first < asks.begin()->first) return best;
+
+    // Only levels inside [best ask, best bid] can trade; candidate prices are
+    // the distinct level prices in that range.
+    const double lo = asks.begin()->first;
+    const double hi = bids.begin()->first;
+    auto bid_end = bids.upper_bound(lo);  // first bid level below lo
+
+    int64_t bid_total = 0;
+    for (auto it = bids.begin(); it != bid_end; ++it) bid_total += it->second.total_qty;
+
+    // Single ascending merge over both sides: asks accumulate from below,
+    // bids at or above p are bid_total minus what has been passed already.
+    int64_t ask_cum = 0, bid_below = 0, best_imbalance = 0;
+    auto a = asks.begin();
+    auto b = std::make_reverse_iterator(bid_end);
+    while ((a != asks.end() && a->first <= hi) || b != bids.rend()) {
+        bool ask_here = a != asks.end() && a->first <= hi;
+        bool bid_here = b != bids.rend();
+        double p = (ask_here && bid_here) ? std::min(a->first, b->first)
+                 : ask_here ? a->first : b->first;
+
+        int64_t bid_cum = bid_total - bid_below;
+        if (bid_here && b->first == p) { bid_below += b->second.total_qty; ++b; }
+        if (ask_here && a->first == p) { ask_cum += a->second.total_qty; ++a; }
+
+        int64_t volume = std::min(bid_cum, ask_cum);
+        int64_t imbalance = bid_cum - ask_cum;
+        int64_t abs_imb = imbalance < 0 ? -imbalance : imbalance;
+        int64_t best_abs = best_imbalance < 0 ? -best_imbalance : best_imbalance;
+        // Max volume, then min surplus; on a full tie follow buy pressure upward
+        if (volume > best.qty ||
+            (volume == best.qty && volume > 0 &&
+             (abs_imb < best_abs || (abs_imb == best_abs && imbalance > 0)))) {
+            best.price = p;
+            best.qty = volume;
+            best_imbalance = imbalance;
+        }
+    }
+    return best;
+}
+
+template <class Allocation>
+AuctionResult BasicOrderBook<Allocation>::uncross() {
+    AuctionResult result = indicative_uncross();
+    in_auction = false;
+    if (result.qty == 0) return result;
+
+    // Execute in price-time priority on both sides, all at the clearing price.
+    // The allocation policy only governs continuous matching.
+    auto b = bids.begin();
+    auto a = asks.begin();
+    while (b != bids.end() && a != asks.end() &&
+           b->first >= result.price && a->first <= result.price) {
+        PriceLevel& bid_level = b->second;
+        PriceLevel& ask_level = a->second;
+        Order& buy = pool[bid_level.head];
+        Order& sell = pool[ask_level.head];
+        int trade_qty = std::min(buy.qty, sell.qty);
+
+        buy.qty -= trade_qty;
+        sell.qty -= trade_qty;
+        bid_level.total_qty -= trade_qty;
+        ask_level.total_qty -= trade_qty;
+        rehash(buy.id, true, b->first, buy.qty + trade_qty, buy.qty);
+        rehash(sell.id, false, a->first, sell.qty + trade_qty, sell.qty);
+        if (bid_level.queue) bid_level.queue->reduce(meta[bid_level.head].queue_slot, trade_qty);
+        if (ask_level.queue) ask_level.queue->reduce(meta[ask_level.head].queue_slot, trade_qty);
+        record_trade(buy.id, sell.id, result.price, trade_qty);
+
+        if (buy.qty == 0) remove_order(bid_level.head);
+        if (sell.qty == 0) remove_order(ask_level.head);
+        level_changed(true, b->first, bid_level);
+        level_changed(false, a->first, ask_level);
+        if (bid_level.count == 0) b = bids.erase(b);
+        if (ask_level.count == 0) a = asks.erase(a);
+    }
+    return result;
+}
+
+template <class Allocation>
+void BasicOrderBook<Allocation>::record_trade(uint64_t buyer, uint64_t seller, double price, int qty) {
+    const Trade trade(buyer, seller, price, qty, stamp());
+    fold(EV_TRADE, buyer, seller ^ price_bits(price), static_cast<uint64_t>(qty));
+    tape.record(price, qty, trade.ts);
+    if (retain_trades) trades.push_back(trade);
+    for (BookListener* l : listeners) l->on_trade(trade);
+}
+
+template <class Allocation>
+void BasicOrderBook<Allocation>::rehash(uint64_t id, bool is_bid, double price, int old_qty, int new_qty) {
+    live_hash ^= order_key(id, is_bid, price, old_qty) ^ order_key(id, is_bid, price, new_qty);
+}
+
+template <class Allocation>
+uint64_t BasicOrderBook<Allocation>::compute_state_hash() const {
+    uint64_t h = 0;
+    auto walk = [&](const auto& side, bool is_bid) {
+        for (const auto& [price, level] : side) {
+            for (OrderHandle o = level.head; o != NIL_ORDER; o = pool[o].next) {
+                h ^= order_key(pool[o].id, is_bid, price, pool[o].qty);
             }
         }
+    };
+    walk(bids, true);
+    walk(asks, false);
+    return h;
+}
+
+template <class Allocation>
+std::chrono::nanoseconds BasicOrderBook<Allocation>::stamp() const {
+    return deterministic_time ? last_time : std::chrono::high_resolution_clock::now().time_since_epoch();
+}
+
+template <class Allocation>
+void BasicOrderBook<Allocation>::fold(uint64_t tag, uint64_t a, uint64_t b, uint64_t c) {
+    // Odd multipliers spread the fields, then splitmix64's finalizer mixes
+    // them into the running value, so order and every field matter
+    uint64_t x = rolling ^ (tag + a * 0x9e3779b97f4a7c15ULL + b * 0xc2b2ae3d27d4eb4fULL + c * 0x165667b19e3779f9ULL);
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+    rolling = x ^ (x >> 31);
+}
+
+template <class Allocation>
+void BasicOrderBook<Allocation>::level_changed(bool is_bid, double price, PriceLevel& level) {
+    if (signal_depth) update_signals(is_bid, price, level);
+    if (listeners.empty()) return;
+    LevelInfo info{price, level.total_qty, static_cast<uint32_t>(level.count)};
+    for (BookListener* l : listeners) l->on_level(is_bid, info);
+}
+
+template <class Allocation>
+void BasicOrderBook<Allocation>::update_signals(bool is_bid, double price, PriceLevel& level) {
+    const int64_t delta = level.total_qty - level.signal_qty;
+    const bool appeared = level.signal_qty == 0 && level.count > 0;
+    level.signal_qty = level.total_qty;
+    SignalBand& band = is_bid ? bid_band : ask_band;
+    // While a side has fewer than signal_depth levels, all of them are in its band
+    const bool inside = band.levels < signal_depth || (is_bid ? price >= band.edge : price <= band.edge);
+    if (!inside) return;
+    if (mass_update && level.count == 0) {
+        (is_bid ? bid_stale : ask_stale) = true;
+        signals_pending = true;
+        return;
+    }
+    if (appeared || level.count == 0) {
+        if (is_bid) rebuild_band(bids, band, signal_depth);
+        else rebuild_band(asks, band, signal_depth);
     } else {
-        auto level_it = asks.find(price);
-        if (level_it != asks.end()) {
-            auto& level = level_it->second;
-            for (auto order_it = level.begin(); order_it != level.end(); ++order_it) {
-                if (order_it->id == id) {
-                    level.erase(order_it);
-                    if (level.empty()) asks.erase(level_it);
-                    order_index.erase(it);
-                    return true;
-                }
-            }
+        band.qty += delta;
+        if (price == band.best_price) band.best_qty = level.total_qty;
+    }
+    if (mass_update) signals_pending = true;
+    else publish_signals();
+}
+
+template <class Allocation>
+void BasicOrderBook<Allocation>::end_mass_update() {
+    mass_update = false;
+    if (bid_stale) rebuild_band(bids, bid_band, signal_depth);
+    if (ask_stale) rebuild_band(asks, ask_band, signal_depth);
+    if (signals_pending) publish_signals();
+    bid_stale = ask_stale = signals_pending = false;
+}
+
+// Emptied levels may still sit in the map until the caller erases them
+template <class Allocation>
+template <class Side>
+void BasicOrderBook<Allocation>::rebuild_band(Side& side, SignalBand& band, size_t depth) {
+    band = SignalBand{};
+    for (auto it = side.begin(); it != side.end() && band.levels < depth; ++it) {
+        PriceLevel& level = it->second;
+        if (level.count == 0) continue;
+        level.signal_qty = level.total_qty;
+        if (band.levels++ == 0) {
+            band.best_price = it->first;
+            band.best_qty = level.total_qty;
         }
+        band.edge = it->first;
+        band.qty += level.total_qty;
+    }
+}
+
+template <class Allocation>
+void BasicOrderBook<Allocation>::publish_signals() {
+    BookSignals s;
+    s.bid_price = bid_band.best_price;
+    s.ask_price = ask_band.best_price;
+    s.bid_qty = bid_band.best_qty;
+    s.ask_qty = ask_band.best_qty;
+    s.bid_depth = bid_band.qty;
+    s.ask_depth = ask_band.qty;
+    s.version = signal_lock->version() + 1;
+    signal_lock->store(s);
+}
+
+template <class Allocation>
+void BasicOrderBook<Allocation>::set_signal_depth(size_t levels) {
+    signal_depth = levels;
+    if (!signal_lock) signal_lock = std::make_unique<SeqLock<BookSignals>>();
+    // Levels outside the band only need a current signal_qty
+    for (auto& entry : bids) entry.second.signal_qty = entry.second.total_qty;
+    for (auto& entry : asks) entry.second.signal_qty = entry.second.total_qty;
+    rebuild_band(bids, bid_band, levels);
+    rebuild_band(asks, ask_band, levels);
+    publish_signals();
+}
+
+template <class Allocation>
+BookSignals BasicOrderBook<Allocation>::signals() const {
+    BookSignals s;
+    if (signal_lock) signal_lock->load(s);
+    return s;
+}
+
+// Indexes every order at the level in FIFO order, with room to grow
+template <class Allocation>
+void BasicOrderBook<Allocation>::build_queue(PriceLevel& level) {
+    level.queue = std::make_unique<QueueIndex>(std::max<size_t>(64, 2 * level.count));
+    for (OrderHandle h = level.head; h != NIL_ORDER; h = pool[h].next) {
+        meta[h].queue_slot = level.queue->push(pool[h].qty);
     }
-    order_index.erase(it);
-    return false;
 }
 
-uint64_t OrderBook::add_market(int qty, bool is_bid) {
-    if (qty <= 0) return 0;
-    Order inc(next_id++, is_bid ? 1e9 : 0.0, qty);  // Extreme price to match any available
-    match(inc, is_bid);
-    return inc.id;
+template <class Allocation>
+bool BasicOrderBook<Allocation>::queue_position(uint64_t id, QueuePosition& out) {
+    const OrderHandle h = order_index.find(id);
+    if (h == NIL_ORDER) return false;
+    PriceLevel& level = *meta[h].level;
+    if (!level.queue) build_queue(level);
+    out = level.queue->ahead(meta[h].queue_slot);
+    return true;
 }
 
-void OrderBook::print_top() const {
+template <class Allocation>
+void BasicOrderBook<Allocation>::remove_listener(BookListener* listener) {
+    listeners.erase(std::remove(listeners.begin(), listeners.end(), listener), listeners.end());
+}
+
+template <class Allocation>
+size_t BasicOrderBook<Allocation>::depth(bool is_bid, LevelInfo* out, size_t max_levels) const {
+    size_t n = 0;
+    auto copy = [&](const auto& side) {
+        for (auto it = side.begin(); it != side.end() && n < max_levels; ++it, ++n) {
+            out[n] = LevelInfo{it->first, it->second.total_qty, static_cast<uint32_t>(it->second.count)};
+        }
+    };
+    if (is_bid) copy(bids);
+    else copy(asks);
+    return n;
+}
+
+template <class Allocation>
+void BasicOrderBook<Allocation>::print_top() const {
     if (!bids.empty()) {
-        auto& top = bids.begin()->second;
-        int total_qty = 0;
-        for (const auto& order : top) total_qty += order.qty;
-        std::cout << "Best Bid: " << bids.begin()->first << " x " << total_qty << std::endl;
+        std::cout << "Best Bid: " << bids.begin()->first << " x " << bids.begin()->second.total_qty << std::endl;
     }
     if (!asks.empty()) {
-        auto& top = asks.begin()->second;
-        int total_qty = 0;
-        for (const auto& order : top) total_qty += order.qty;
-        std::cout << "Best Ask: " << asks.begin()->first << " x " << total_qty << std::endl;
+        std::cout << "Best Ask: " << asks.begin()->first << " x " << asks.begin()->second.total_qty << std::endl;
     }
 }
 
-void OrderBook::print_trades() const {
+template <class Allocation>
+void BasicOrderBook<Allocation>::print_trades() const {
     std::cout << "\n=== Trades ===" << std::endl;
     for (const auto& trade : trades) {
         std::cout << "Trade: Buyer #" << trade.buyer_id 
@@ -142,24 +579,31 @@ void OrderBook::print_trades() const {
     std::cout << "Total trades: " << trades.size() << "\n" << std::endl;
 }
 
-void OrderBook::clear() {
+template <class Allocation>
+void BasicOrderBook<Allocation>::clear() {
     bids.clear();
     asks.clear();
+    pool.clear();
+    meta.clear();
+    free_slots.clear();
     order_index.clear();
+    owners.clear();
     trades.clear();
+    tape.clear();
+    in_auction = false;
+    expiries.clear();
+    last_time = std::chrono::nanoseconds{0};
+    rolling = 0;
+    live_hash = 0;
+    if (signal_lock) set_signal_depth(signal_depth);
 }
 
-size_t OrderBook::total_orders() const {
+template <class Allocation>
+size_t BasicOrderBook<Allocation>::total_orders() const {
     return order_index.size();
 }
 
-void OrderBook::benchmark(int n) {
-    auto start = std::chrono::high_resolution_clock::now();
-    for (int i = 0; i < n; ++i) {
-        add_limit(100.0 + (i % 10) * 0.1, 100, i % 2 == 0);
-    }
-    auto end = std::chrono::high_resolution_clock::now();
-    std::cout << "Inserted " << n << " orders in " 
-              << std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count() / 1e6 
-              << " ms\n";
-}
\ No newline at end of file
+// Instantiations for the shipped allocation policies
+template class BasicOrderBook<FifoAllocation>;
+template class BasicOrderBook<ProRataAllocation>;
+template class BasicOrderBook<TopOrderProRataAllocation>;
@@ -1,19 +1,52 @@
 #pragma once
+#include "allocation.hpp"
+#include "book_events.hpp"
+#include "order_index.hpp"
+#include "queue_index.hpp"
+#include "seqlock.hpp"
+#include "timer_wheel.hpp"
+#include "trade_analytics.hpp"
+#include <cstdint>
 #include <map>
-#include <deque>
+#include <memory>
 #include <unordered_map>
 #include <vector>
 #include <chrono>
 #include <iostream>
 
-struct Order {
+struct PriceLevel;
+
+// Resting order, packed to 32 bytes so two share a cache line. The price is
+// the level's map key; fields only needed on insert/cancel live in OrderMeta.
+struct alignas(32) Order {
     uint64_t id;
-    double price;
-    int qty;
     std::chrono::nanoseconds ts;
-    Order(uint64_t i, double p, int q) 
-        : id(i), price(p), qty(q), 
-          ts(std::chrono::high_resolution_clock::now().time_since_epoch()) {}
+    int32_t qty;
+    uint32_t owner;
+    OrderHandle prev = NIL_ORDER, next = NIL_ORDER;  // level FIFO links
+    Order(uint64_t i, int32_t q, uint32_t o = 0)
+        : Order(i, q, o, std::chrono::high_resolution_clock::now().time_since_epoch()) {}
+    Order(uint64_t i, int32_t q, uint32_t o, std::chrono::nanoseconds t)
+        : id(i), ts(t), qty(q), owner(o) {}
+};
+static_assert(sizeof(Order) == 32, "Order must stay at half a cache line");
+
+// Cold per-order state, stored in a pool parallel to the orders
+struct OrderMeta {
+    double price = 0.0;
+    PriceLevel* level = nullptr;                                 // owning level while resting
+    OrderHandle owner_prev = NIL_ORDER, owner_next = NIL_ORDER;  // owner's live orders
+    uint32_t queue_slot = 0;                                     // in level->queue, if built
+    bool is_bid = false;
+};
+
+// Intrusive FIFO of pooled orders resting at one price
+struct PriceLevel {
+    OrderHandle head = NIL_ORDER, tail = NIL_ORDER;
+    size_t count = 0;
+    int64_t total_qty = 0;
+    int64_t signal_qty = 0;  // total_qty last folded into the book signals
+    std::unique_ptr<QueueIndex> queue;  // built by the first queue_position() here
 };
 
 struct Trade {
@@ -22,27 +55,219 @@ struct Trade {
     int qty;
     std::chrono::nanoseconds ts;
     Trade(uint64_t b, uint64_t s, double p, int q)
-        : buyer_id(b), seller_id(s), price(p), qty(q),
-          ts(std::chrono::high_resolution_clock::now().time_since_epoch()) {}
+        : Trade(b, s, p, q, std::chrono::high_resolution_clock::now().time_since_epoch()) {}
+    Trade(uint64_t b, uint64_t s, double p, int q, std::chrono::nanoseconds t)
+        : buyer_id(b), seller_id(s), price(p), qty(q), ts(t) {}
 };
 
-class OrderBook {
-    std::map<double, std::deque<Order>, std::greater<>> bids;  // price → [orders], descending
-    std::map<double, std::deque<Order>> asks;                  // price → [orders], ascending
-    std::unordered_map<uint64_t, std::pair<double, bool>> order_index;  // id → (price, is_bid)
+// Outcome of a call auction: single clearing price and the volume crossed at it
+struct AuctionResult {
+    double price = 0.0;   // 0 when the book does not cross
+    int64_t qty = 0;
+};
+
+// Touch and top-N depth aggregates published by the book, see
+// BasicOrderBook::set_signal_depth(). Prices and quantities are 0 on an
+// empty side; the derived signals are 0 when an input side is empty.
+struct BookSignals {
+    double bid_price = 0.0, ask_price = 0.0;
+    int64_t bid_qty = 0, ask_qty = 0;        // at the touch
+    int64_t bid_depth = 0, ask_depth = 0;    // summed over the top N levels
+    uint64_t version = 0;                    // publish count
+
+    // (bid - ask) / (bid + ask), in [-1, 1]
+    double imbalance() const { return ratio(bid_qty, ask_qty); }
+    double depth_imbalance() const { return ratio(bid_depth, ask_depth); }
+    // Touch prices weighted by the opposite side's quantity
+    double microprice() const {
+        if (bid_qty <= 0 || ask_qty <= 0) return 0.0;
+        return (bid_price * static_cast<double>(ask_qty) + ask_price * static_cast<double>(bid_qty)) /
+               static_cast<double>(bid_qty + ask_qty);
+    }
+
+private:
+    static double ratio(int64_t b, int64_t a) {
+        return b + a > 0 ? static_cast<double>(b - a) / static_cast<double>(b + a) : 0.0;
+    }
+};
+
+// Allocation is the per-level matching policy (see allocation.hpp). Member
+// definitions live in orderbook.cpp, which instantiates the shipped policies.
+template <class Allocation = FifoAllocation>
+class BasicOrderBook {
+    // Live orders of one participant, linked through OrderMeta::owner_prev/next
+    struct OwnerOrders {
+        OrderHandle head = NIL_ORDER;
+        size_t count = 0;
+    };
+
+    // What the allocation policies see of a level: a FIFO queue of Order&
+    // that unlinks (and releases) orders as they are popped or filled.
+    class LevelView {
+        BasicOrderBook& book;
+        PriceLevel& level;
+
+    public:
+        class iterator {
+            std::vector<Order>* pool;
+            OrderHandle h;
+
+        public:
+            iterator(std::vector<Order>* p, OrderHandle handle) : pool(p), h(handle) {}
+            Order& operator*() const { return (*pool)[h]; }
+            iterator& operator++() { h = (*pool)[h].next; return *this; }
+            bool operator!=(const iterator& other) const { return h != other.h; }
+        };
+
+        LevelView(BasicOrderBook& b, PriceLevel& l) : book(b), level(l) {}
+        bool empty() const { return level.head == NIL_ORDER; }
+        size_t size() const { return level.count; }
+        Order& front() { return book.pool[level.head]; }
+        void pop_front() { book.remove_order(level.head); }
+        void remove_filled();
+        iterator begin() { return iterator(&book.pool, level.head); }
+        iterator end() { return iterator(&book.pool, NIL_ORDER); }
+    };
+
+    std::map<double, PriceLevel, std::greater<>> bids;  // price → level, descending
+    std::map<double, PriceLevel> asks;                  // price → level, ascending
+    std::vector<Order> pool;                            // resting orders, addressed by handle
+    std::vector<OrderMeta> meta;                        // cold fields, same handles
+    std::vector<OrderHandle> free_slots;
+    OrderIndex order_index;                             // id → pool slot
+    std::unordered_map<uint32_t, OwnerOrders> owners;
+    std::vector<double> emptied_bids, emptied_asks;     // levels left empty by a mass cancel
     std::vector<Trade> trades;
+    bool retain_trades = true;
+    TradeAnalytics tape;                                // running VWAP, bars and counts
+    std::vector<BookListener*> listeners;
     uint64_t next_id = 1;
+    bool in_auction = false;
+    Allocation allocation;
+    TimerWheel expiries;                       // GTT order ids by expiry time
+    std::chrono::nanoseconds last_time{0};     // latest advance_time()
+    std::vector<uint64_t> expired_scratch;
+    bool deterministic_time = false;
+    uint64_t rolling = 0;                      // see checksum()
+    uint64_t live_hash = 0;                    // see state_hash()
+
+    // Writer side of signals(): the top signal_depth non-empty levels of a side
+    struct SignalBand {
+        size_t levels = 0;
+        double edge = 0.0;            // worst price in the band
+        double best_price = 0.0;
+        int64_t best_qty = 0, qty = 0;
+    };
+    size_t signal_depth = 0;          // 0 = signals off
+    SignalBand bid_band, ask_band;
+    // During cancel_all/cancel_side emptied levels only mark their band stale;
+    // end_mass_update() rebuilds each stale band once and publishes once
+    bool mass_update = false, bid_stale = false, ask_stale = false, signals_pending = false;
+    std::unique_ptr<SeqLock<BookSignals>> signal_lock;  // heap, so the book stays movable
 
-    void match(Order& incoming, bool is_bid);
+    int match(uint64_t id, double price, int qty, bool is_bid);
+    void rest(uint64_t id, double price, int qty, bool is_bid, uint32_t owner);
+    void remove_order(OrderHandle h);
+    void erase_emptied();
+    void record_trade(uint64_t buyer, uint64_t seller, double price, int qty);
+    void level_changed(bool is_bid, double price, PriceLevel& level);
+    std::chrono::nanoseconds stamp() const;
+    void fold(uint64_t tag, uint64_t a, uint64_t b, uint64_t c);
+    void rehash(uint64_t id, bool is_bid, double price, int old_qty, int new_qty);
+    void update_signals(bool is_bid, double price, PriceLevel& level);
+    template <class Side>
+    static void rebuild_band(Side& side, SignalBand& band, size_t depth);
+    void publish_signals();
+    void end_mass_update();
+    void build_queue(PriceLevel& level);
 
 public:
-    uint64_t add_limit(double price, int qty, bool is_bid);
+    // Returns 0 (rejected) for qty <= 0 or a NaN/infinite price
+    uint64_t add_limit(double price, int qty, bool is_bid, uint32_t owner = 0);
     uint64_t add_market(int qty, bool is_bid);
     bool cancel(uint64_t id);
+    // Same price and smaller qty reduces in place and keeps queue priority;
+    // anything else is cancel/replace under the same id (and may match).
+    // qty <= 0 cancels. Returns false if the order is not resting or the
+    // price is NaN/infinite.
+    bool modify(uint64_t id, double price, int qty);
+
+    // Mass cancel: every live order of one owner / one side in a single pass,
+    // with emptied price levels erased together afterwards. Return the count.
+    size_t cancel_all(uint32_t owner);
+    size_t cancel_side(bool is_bid);
+
+    // Good-till-time: rests like add_limit until advance_time() passes
+    // expire_at. Returns 0 if expire_at is not after the current book time.
+    uint64_t add_limit(double price, int qty, bool is_bid, std::chrono::nanoseconds expire_at,
+                       uint32_t owner = 0);
+    // Moves book time forward and cancels every due GTT order; returns how many
+    // were still resting. Filled or cancelled orders drop out lazily.
+    size_t advance_time(std::chrono::nanoseconds now);
+
+    // Call auction: while active, limit orders rest without matching (the book
+    // may cross) and market orders are rejected. uncross() executes every fill
+    // at the volume-maximizing price and returns to continuous matching.
+    void begin_auction() { in_auction = true; }
+    bool auction_active() const { return in_auction; }
+    AuctionResult indicative_uncross() const;
+    AuctionResult uncross();
+
+    // Deterministic mode stamps orders and trades with book time (the latest
+    // advance_time(), i.e. the sequenced input's clock) instead of the wall
+    // clock. Ids already come from a per-book sequence, so two fresh books fed
+    // the same commands end up identical, timestamps included.
+    void set_deterministic(bool on) { deterministic_time = on; }
+    bool deterministic() const { return deterministic_time; }
+    // Rolling checksum over every rest, fill, removal and in-place reduce, in
+    // the order they happened; one multiply-xorshift mix per event. Replicas
+    // compare it every N commands instead of walking both books.
+    uint64_t checksum() const { return rolling; }
+    // Zobrist-style hash of the resting orders: the XOR of one mixed 64-bit
+    // key per (id, side, price, qty), kept up to date in O(1) on every add,
+    // fill, reduce and cancel. Unlike checksum() it depends only on the
+    // current state, so two books holding the same orders agree however they
+    // got there. compute_state_hash() recomputes it by walking the book.
+    uint64_t state_hash() const { return live_hash; }
+    uint64_t compute_state_hash() const;
+
+    // Order-book imbalance and microprice inputs, maintained from level deltas:
+    // a change inside the top `levels` of a side adjusts the aggregates in
+    // O(1); a level entering or leaving them rebuilds that side's band in
+    // O(levels). Every change that reaches the band is published through a
+    // seqlock. Call on the matching thread; 0 turns the signals off.
+    void set_signal_depth(size_t levels);
+    // Any thread, lock-free; all zero while signals are off
+    BookSignals signals() const;
+
+    // Quantity and number of orders ahead of a resting order at its level, in
+    // time priority. The first query at a level indexes it in O(n); from then
+    // on the level keeps a Fenwick tree up to date (O(log n) per add, fill and
+    // cancel there) and queries cost O(log n). False if the order is not resting.
+    bool queue_position(uint64_t id, QueuePosition& out);
+
+    // Listeners are not owned and must outlive the book (or be removed)
+    void add_listener(BookListener* listener) { listeners.push_back(listener); }
+    void remove_listener(BookListener* listener);
+    // Copies up to max_levels best levels of one side, best first
+    size_t depth(bool is_bid, LevelInfo* out, size_t max_levels) const;
+
     void print_top() const;
     void print_trades() const;
     void clear();
     size_t total_orders() const;
+    // Id the next accepted order will get; ids are never reused, not even after clear()
+    uint64_t next_order_id() const { return next_id; }
+    bool contains(uint64_t id) const { return order_index.contains(id); }
     const std::vector<Trade>& get_trades() const { return trades; }
-    void benchmark(int n_orders);
-};
\ No newline at end of file
+    // Every trade also updates analytics() in O(1). With retention off,
+    // get_trades() stays empty and the history is never stored; listeners
+    // and analytics still see each trade.
+    void set_retain_trades(bool on) { retain_trades = on; }
+    const TradeAnalytics& analytics() const { return tape; }
+    void set_bar_interval(std::chrono::nanoseconds interval) { tape.set_interval(interval); }
+};
+
+using OrderBook = BasicOrderBook<FifoAllocation>;
+using ProRataOrderBook = BasicOrderBook<ProRataAllocation>;
+using TopOrderProRataOrderBook = BasicOrderBook<TopOrderProRataAllocation>;
\ No newline at end of file
@@ -0,0 +1,202 @@
+// Regression gate for `make perf-check`: runs the add/cancel/match/flow
+// scenarios several times, writes the per-run samples as JSON and compares
+// them with a committed baseline using a one-sided Mann-Whitney U test.
+// The allowed slowdown per scenario is the threshold plus the run-to-run
+// drift measured when the baseline was recorded.
+#include "order_flow.hpp"
+#include "orderbook.hpp"
+#include "perf_stats.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <sched.h>
+#include <thread>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+volatile int64_t sink;
+constexpr size_t N = 100000;
+
+double elapsed_ns(Clock::time_point start) {
+    return static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count());
+}
+
+// Resting inserts over 200 non-crossing levels
+double scenario_add() {
+    OrderBook ob;
+    auto start = Clock::now();
+    for (size_t i = 0; i < N; ++i) {
+        bool is_bid = i % 2 == 0;
+        ob.add_limit(is_bid ? 99.0 - static_cast<double>(i % 100) * 0.01
+                            : 101.0 + static_cast<double>(i % 100) * 0.01, 10, is_bid);
+    }
+    double ns = elapsed_ns(start);
+    sink = static_cast<int64_t>(ob.total_orders());
+    return ns / N;
+}
+
+// Cancels of resting orders in scattered order
+double scenario_cancel() {
+    OrderBook ob;
+    std::vector<uint64_t> ids;
+    ids.reserve(N);
+    for (size_t i = 0; i < N; ++i) ids.push_back(ob.add_limit(90.0 + static_cast<double>(i % 100) * 0.1, 10, true));
+    uint64_t x = 88172645463325252ull;
+    for (size_t i = N - 1; i > 0; --i) {
+        x = x * 6364136223846793005ull + 1442695040888963407ull;
+        std::swap(ids[i], ids[(x >> 33) % (i + 1)]);
+    }
+    auto start = Clock::now();
+    for (uint64_t id : ids) ob.cancel(id);
+    double ns = elapsed_ns(start);
+    sink = static_cast<int64_t>(ob.total_orders());
+    return ns / N;
+}
+
+// Aggressive orders each filling one resting order across 100 levels
+double scenario_match() {
+    OrderBook ob;
+    for (size_t i = 0; i < N; ++i) ob.add_limit(100.0 + static_cast<double>(i % 100) * 0.01, 10, false);
+    auto start = Clock::now();
+    for (size_t i = 0; i < N; ++i) ob.add_market(10, true);
+    double ns = elapsed_ns(start);
+    sink = static_cast<int64_t>(ob.get_trades().size());
+    return ns / N;
+}
+
+// Production-like synthetic mix (order_flow.hpp)
+double scenario_flow(const std::vector<FlowEvent>& events) {
+    OrderBook ob;
+    auto start = Clock::now();
+    for (const auto& e : events) apply_flow(ob, e);
+    double ns = elapsed_ns(start);
+    sink = static_cast<int64_t>(ob.total_orders());
+    return ns / static_cast<double>(events.size());
+}
+
+void usage() {
+    std::cerr << "usage: perf_check [--runs N] [--sessions K] [--pause SEC] [--warmup N]\n"
+                 "                  [--cpu N] [--out FILE] [--baseline FILE]\n"
+                 "                  [--threshold PCT] [--alpha P]\n"
+                 "  Records K sessions (default 1) of N runs, SEC seconds apart, each after\n"
+                 "  N discarded warm-up rounds (default 5), optionally pinned to one CPU.\n"
+                 "  Fails when a scenario's median is more than PCT% (default 10) plus the\n"
+                 "  baseline's recorded drift above the baseline and Mann-Whitney rejects\n"
+                 "  'not slower' at level P (default 0.01).\n";
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    int runs = 40, sessions = 1, pause = 0, warmup = 5, cpu = -1;
+    std::string out_path = "perf/results.json";
+    std::string baseline_path;
+    double threshold = 10.0, alpha = 0.01;
+    for (int i = 1; i < argc; ++i) {
+        bool has_value = i + 1 < argc;
+        if (std::strcmp(argv[i], "--runs") == 0 && has_value) runs = std::atoi(argv[++i]);
+        else if (std::strcmp(argv[i], "--sessions") == 0 && has_value) sessions = std::max(1, std::atoi(argv[++i]));
+        else if (std::strcmp(argv[i], "--pause") == 0 && has_value) pause = std::atoi(argv[++i]);
+        else if (std::strcmp(argv[i], "--warmup") == 0 && has_value) warmup = std::atoi(argv[++i]);
+        else if (std::strcmp(argv[i], "--cpu") == 0 && has_value) cpu = std::atoi(argv[++i]);
+        else if (std::strcmp(argv[i], "--out") == 0 && has_value) out_path = argv[++i];
+        else if (std::strcmp(argv[i], "--baseline") == 0 && has_value) baseline_path = argv[++i];
+        else if (std::strcmp(argv[i], "--threshold") == 0 && has_value) threshold = std::atof(argv[++i]);
+        else if (std::strcmp(argv[i], "--alpha") == 0 && has_value) alpha = std::atof(argv[++i]);
+        else {
+            usage();
+            return 2;
+        }
+    }
+
+    // Pinning keeps the caches warm and avoids migrations between runs
+    if (cpu >= 0) {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(cpu, &set);
+        if (sched_setaffinity(0, sizeof(set), &set) != 0) {
+            std::cerr << "perf_check: cannot pin to CPU " << cpu << ", running unpinned\n";
+        }
+    }
+
+    OrderFlowGenerator gen;
+    std::vector<FlowEvent> events(200000);
+    for (auto& e : events) e = gen.next();
+
+    const std::vector<std::pair<std::string, std::function<double()>>> scenarios = {
+        {"add", scenario_add},
+        {"cancel", scenario_cancel},
+        {"match", scenario_match},
+        {"flow", [&] { return scenario_flow(events); }},
+    };
+
+    // Each session: discarded warm-up rounds, then interleaved runs so drift
+    // hits every scenario alike. Sessions apart in time show how far the
+    // machine drifts between recordings.
+    perf::Results results;
+    for (int session = 0; session < sessions; ++session) {
+        if (session > 0) std::this_thread::sleep_for(std::chrono::seconds(pause));
+        for (int r = 0; r < warmup; ++r) {
+            for (const auto& s : scenarios) s.second();
+        }
+        for (int r = 0; r < runs; ++r) {
+            for (const auto& s : scenarios) results[s.first].push_back(s.second());
+        }
+    }
+    perf::Drift drift;
+    for (const auto& [name, samples] : results) drift[name] = perf::block_drift(samples, sessions > 1 ? sessions : 4);
+    if (!perf::write_json(out_path, results, drift)) {
+        std::cerr << "perf_check: cannot write " << out_path << "\n";
+        return 2;
+    }
+    std::cout << "wrote " << sessions * runs << " runs per scenario to " << out_path << "\n";
+
+    perf::Results baseline;
+    perf::Drift baseline_drift;
+    if (baseline_path.empty()) return 0;
+    if (!perf::read_json(baseline_path, baseline, &baseline_drift)) {
+        std::cerr << "perf_check: no readable baseline at " << baseline_path
+                  << " (create one with make perf-baseline)\n";
+        return 2;
+    }
+
+    bool regressed = false;
+    std::cout << std::left << std::setw(10) << "scenario" << std::right
+              << std::setw(12) << "baseline" << std::setw(12) << "current"
+              << std::setw(10) << "change" << std::setw(9) << "allowed" << std::setw(10) << "p" << "  verdict\n";
+    std::cout << std::fixed;
+    for (const auto& [name, samples] : results) {
+        auto it = baseline.find(name);
+        if (it == baseline.end()) {
+            std::cout << std::left << std::setw(10) << name << std::right << "  (not in baseline)\n";
+            continue;
+        }
+        const double base = perf::median(it->second), cur = perf::median(samples);
+        const double change = base > 0 ? (cur - base) / base * 100.0 : 0.0;
+        const perf::MannWhitney mw = perf::mann_whitney(it->second, samples);
+        const auto d = baseline_drift.find(name);
+        const double allowed = threshold + (d != baseline_drift.end() ? d->second : 0.0);
+        const bool bad = change > allowed && mw.p_greater < alpha;
+        regressed |= bad;
+        std::cout << std::left << std::setw(10) << name << std::right << std::setprecision(1)
+                  << std::setw(9) << base << " ns" << std::setw(9) << cur << " ns"
+                  << std::setw(9) << std::showpos << change << "%" << std::noshowpos
+                  << std::setw(8) << allowed << "%"
+                  << std::setprecision(4) << std::setw(10) << mw.p_greater
+                  << "  " << (bad ? "REGRESSED" : change < -allowed && 1.0 - mw.p_greater < alpha ? "faster" : "ok")
+                  << "\n";
+    }
+    if (regressed) {
+        std::cout << std::setprecision(1) << "perf-check FAILED: latency regressed beyond " << threshold
+                  << "% plus drift\n";
+        return 1;
+    }
+    std::cout << "perf-check passed\n";
+    return 0;
+}
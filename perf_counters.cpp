@@ -0,0 +1,129 @@
+#include "perf_counters.hpp"
+#include <cerrno>
+#include <cstring>
+#include <iomanip>
+#include <linux/perf_event.h>
+#include <ostream>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace {
+
+constexpr uint64_t EVENT_CONFIG[CounterSample::EVENTS] = {
+    PERF_COUNT_HW_CPU_CYCLES,
+    PERF_COUNT_HW_INSTRUCTIONS,
+    PERF_COUNT_HW_CACHE_MISSES,
+    PERF_COUNT_HW_BRANCH_MISSES,
+};
+
+int open_event(uint64_t config, int group_fd) {
+    perf_event_attr attr;
+    std::memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.config = config;
+    attr.disabled = group_fd < 0;  // members follow the leader
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    return static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, group_fd, 0));
+}
+
+}  // namespace
+
+CounterSample& CounterSample::operator+=(const CounterSample& other) {
+    for (int i = 0; i < EVENTS; ++i) value[i] += other.value[i];
+    return *this;
+}
+
+CounterSample CounterSample::operator-(const CounterSample& other) const {
+    CounterSample d;
+    // Multiplex scaling can make a later read slightly smaller; clamp at zero
+    for (int i = 0; i < EVENTS; ++i) d.value[i] = value[i] > other.value[i] ? value[i] - other.value[i] : 0;
+    return d;
+}
+
+PerfCounters::~PerfCounters() { close(); }
+
+bool PerfCounters::open() {
+    close();
+    int& leader = fds[CounterSample::Cycles];
+    leader = open_event(EVENT_CONFIG[CounterSample::Cycles], -1);
+    if (leader < 0) {
+        err = std::string("perf_event_open: ") + std::strerror(errno);
+        if (errno == EACCES || errno == EPERM) err += " (check kernel.perf_event_paranoid)";
+        else if (errno == ENOENT || errno == EOPNOTSUPP) err += " (no hardware PMU, e.g. in a container or VM)";
+        return false;
+    }
+    for (int e = CounterSample::Instructions; e < CounterSample::EVENTS; ++e) {
+        fds[e] = open_event(EVENT_CONFIG[e], leader);
+    }
+    err.clear();
+    return true;
+}
+
+void PerfCounters::close() {
+    // Members first; closing the leader would leave them as singleton groups
+    for (int e = CounterSample::EVENTS - 1; e >= 0; --e) {
+        if (fds[e] >= 0) ::close(fds[e]);
+        fds[e] = -1;
+    }
+}
+
+unsigned PerfCounters::present() const {
+    unsigned mask = 0;
+    for (int e = 0; e < CounterSample::EVENTS; ++e) {
+        if (fds[e] >= 0) mask |= 1u << e;
+    }
+    return mask;
+}
+
+void PerfCounters::enable() {
+    if (!available()) return;
+    ioctl(fds[CounterSample::Cycles], PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+    ioctl(fds[CounterSample::Cycles], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+}
+
+void PerfCounters::disable() {
+    if (!available()) return;
+    ioctl(fds[CounterSample::Cycles], PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+}
+
+bool PerfCounters::read(CounterSample& out) const {
+    out = CounterSample{};
+    if (!available()) return false;
+    // { nr, time_enabled, time_running, value[nr] } in group creation order
+    uint64_t buf[3 + CounterSample::EVENTS];
+    const ssize_t n = ::read(fds[CounterSample::Cycles], buf, sizeof(buf));
+    if (n < static_cast<ssize_t>(4 * sizeof(uint64_t))) return false;
+    const uint64_t nr = buf[0], enabled = buf[1], running = buf[2];
+    const double scale = running > 0 && running < enabled
+        ? static_cast<double>(enabled) / static_cast<double>(running) : 1.0;
+    uint64_t slot = 0;
+    for (int e = 0; e < CounterSample::EVENTS && slot < nr; ++e) {
+        if (fds[e] < 0) continue;
+        out.value[e] = static_cast<uint64_t>(static_cast<double>(buf[3 + slot++]) * scale);
+    }
+    return true;
+}
+
+void CounterTotals::print(std::ostream& os, const char* name, unsigned present) const {
+    const auto per_op = [&](CounterSample::Event e) {
+        return ops ? static_cast<double>(sum.value[e]) / static_cast<double>(ops) : 0.0;
+    };
+    const auto field = [&](const char* label, CounterSample::Event e, int precision) {
+        os << "  " << label << ' ';
+        if (present & (1u << e)) os << std::setprecision(precision) << std::setw(8) << per_op(e);
+        else os << std::setw(8) << "n/a";
+    };
+    os << std::left << std::setw(10) << name << std::right << " ops=" << std::setw(9) << ops << std::fixed;
+    field("cycles", CounterSample::Cycles, 1);
+    field("instr", CounterSample::Instructions, 1);
+    const double cycles = static_cast<double>(sum.value[CounterSample::Cycles]);
+    os << "  IPC " << std::setprecision(2) << std::setw(5)
+       << (cycles > 0 ? static_cast<double>(sum.value[CounterSample::Instructions]) / cycles : 0.0);
+    field("cache-miss", CounterSample::CacheMisses, 3);
+    field("br-miss", CounterSample::BranchMisses, 3);
+    os << " (per op)\n";
+}
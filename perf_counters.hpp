@@ -0,0 +1,61 @@
+#pragma once
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+
+// Hardware performance counters read through perf_event_open(2).
+//
+// Cycles, instructions, cache misses and branch misses are opened as one
+// event group on the calling thread, counting user space only. The kernel
+// schedules a group as a unit and one read() returns every member, so the
+// values always describe the same interval. In containers or VMs without a
+// PMU open() fails and callers fall back to wall-clock timing.
+struct CounterSample {
+    enum Event { Cycles, Instructions, CacheMisses, BranchMisses, EVENTS };
+    uint64_t value[EVENTS] = {};
+
+    CounterSample& operator+=(const CounterSample& other);
+    CounterSample operator-(const CounterSample& other) const;
+};
+
+class PerfCounters {
+public:
+    PerfCounters() = default;
+    ~PerfCounters();
+    PerfCounters(const PerfCounters&) = delete;
+    PerfCounters& operator=(const PerfCounters&) = delete;
+
+    // Opens the group for the calling thread; false (see error()) if the
+    // cycle counter itself is unavailable
+    bool open();
+    void close();
+    bool available() const { return fds[CounterSample::Cycles] >= 0; }
+    // Members the PMU refused (e.g. no cache events in a VM) read as zero
+    bool has(CounterSample::Event e) const { return fds[e] >= 0; }
+    // Bit e set when has(e)
+    unsigned present() const;
+    const std::string& error() const { return err; }
+
+    void enable();   // resets and starts the whole group
+    void disable();
+    // Totals since enable(), scaled up if the group was multiplexed
+    bool read(CounterSample& out) const;
+
+private:
+    int fds[CounterSample::EVENTS] = {-1, -1, -1, -1};
+    std::string err;
+};
+
+// Counter deltas accumulated over many operations of one kind
+struct CounterTotals {
+    CounterSample sum;
+    uint64_t ops = 0;
+
+    void add(const CounterSample& delta, uint64_t n = 1) {
+        sum += delta;
+        ops += n;
+    }
+    // One line of per-op averages: cycles, instructions, IPC, cache and
+    // branch misses ("n/a" for members missing from the present() mask)
+    void print(std::ostream& os, const char* name, unsigned present) const;
+};
@@ -0,0 +1,181 @@
+#include "perf_stats.hpp"
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iterator>
+
+namespace perf {
+
+double median(std::vector<double> v) {
+    if (v.empty()) return 0.0;
+    std::sort(v.begin(), v.end());
+    size_t n = v.size();
+    return n % 2 ? v[n / 2] : (v[n / 2 - 1] + v[n / 2]) / 2.0;
+}
+
+double block_drift(const std::vector<double>& samples, int blocks) {
+    const size_t per_block = samples.size() / static_cast<size_t>(std::max(blocks, 1));
+    const double overall = median(samples);
+    if (per_block == 0 || overall <= 0.0) return 0.0;
+    double lo = 0.0, hi = 0.0;
+    for (int b = 0; b < blocks; ++b) {
+        const auto first = samples.begin() + static_cast<std::ptrdiff_t>(b * per_block);
+        const double m = median(std::vector<double>(first, first + static_cast<std::ptrdiff_t>(per_block)));
+        lo = b == 0 ? m : std::min(lo, m);
+        hi = b == 0 ? m : std::max(hi, m);
+    }
+    return (hi - lo) / overall * 100.0;
+}
+
+MannWhitney mann_whitney(const std::vector<double>& baseline, const std::vector<double>& current) {
+    MannWhitney r;
+    const size_t n1 = current.size(), n2 = baseline.size();
+    if (n1 < 2 || n2 < 2) return r;
+
+    // Pool and rank, averaging the ranks of tied values
+    std::vector<std::pair<double, bool>> pooled;  // value, from current
+    for (double v : current) pooled.emplace_back(v, true);
+    for (double v : baseline) pooled.emplace_back(v, false);
+    std::sort(pooled.begin(), pooled.end());
+
+    const double n = static_cast<double>(n1 + n2);
+    double rank_sum = 0.0, tie_term = 0.0;
+    for (size_t i = 0; i < pooled.size();) {
+        size_t j = i;
+        while (j < pooled.size() && pooled[j].first == pooled[i].first) ++j;
+        const double avg_rank = (static_cast<double>(i + 1) + static_cast<double>(j)) / 2.0;
+        for (size_t k = i; k < j; ++k) {
+            if (pooled[k].second) rank_sum += avg_rank;
+        }
+        const double t = static_cast<double>(j - i);
+        tie_term += t * t * t - t;
+        i = j;
+    }
+
+    const double a = static_cast<double>(n1), b = static_cast<double>(n2);
+    r.u = rank_sum - a * (a + 1.0) / 2.0;
+    const double mean = a * b / 2.0;
+    const double var = a * b / 12.0 * ((n + 1.0) - tie_term / (n * (n - 1.0)));
+    if (var <= 0.0) return r;  // every value identical
+    // Continuity correction toward the mean
+    r.z = (r.u - mean - 0.5) / std::sqrt(var);
+    r.p_greater = 0.5 * std::erfc(r.z / std::sqrt(2.0));
+    return r;
+}
+
+bool write_json(const std::string& path, const Results& results, const Drift& drift) {
+    std::ofstream out(path);
+    if (!out) return false;
+    out << "{\n  \"unit\": \"ns/op\",\n  \"scenarios\": {";
+    bool first = true;
+    for (const auto& [name, samples] : results) {
+        out << (first ? "\n" : ",\n") << "    \"" << name << "\": [";
+        for (size_t i = 0; i < samples.size(); ++i) {
+            out << (i ? ", " : "") << std::fixed << std::setprecision(3) << samples[i];
+        }
+        out << "]";
+        first = false;
+    }
+    out << "\n  }";
+    if (!drift.empty()) {
+        out << ",\n  \"drift\": {";
+        first = true;
+        for (const auto& [name, pct] : drift) {
+            out << (first ? "\n" : ",\n") << "    \"" << name << "\": " << std::fixed << std::setprecision(2) << pct;
+            first = false;
+        }
+        out << "\n  }";
+    }
+    out << "\n}\n";
+    return static_cast<bool>(out);
+}
+
+namespace {
+// Minimal reader for the layout write_json produces
+struct JsonCursor {
+    std::string s;
+    size_t pos = 0;
+
+    void skip_ws() {
+        while (pos < s.size() && std::isspace(static_cast<unsigned char>(s[pos]))) ++pos;
+    }
+    bool eat(char c) {
+        skip_ws();
+        if (pos < s.size() && s[pos] == c) {
+            ++pos;
+            return true;
+        }
+        return false;
+    }
+    bool string(std::string& out) {
+        if (!eat('"')) return false;
+        size_t end = s.find('"', pos);
+        if (end == std::string::npos) return false;
+        out = s.substr(pos, end - pos);
+        pos = end + 1;
+        return true;
+    }
+    bool number(double& v) {
+        skip_ws();
+        const char* begin = s.c_str() + pos;
+        char* end = nullptr;
+        v = std::strtod(begin, &end);
+        if (end == begin) return false;
+        pos += static_cast<size_t>(end - begin);
+        return true;
+    }
+};
+}  // namespace
+
+bool read_json(const std::string& path, Results& results, Drift* drift) {
+    std::ifstream in(path);
+    if (!in) return false;
+    JsonCursor c;
+    c.s.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+
+    results.clear();
+    if (drift) drift->clear();
+    std::string key, unit;
+    if (!c.eat('{')) return false;
+    do {
+        if (!c.string(key) || !c.eat(':')) return false;
+        if (key == "unit") {
+            if (!c.string(unit)) return false;
+        } else if (key == "scenarios") {
+            if (!c.eat('{')) return false;
+            if (c.eat('}')) continue;
+            do {
+                std::string name;
+                if (!c.string(name) || !c.eat(':') || !c.eat('[')) return false;
+                std::vector<double>& samples = results[name];
+                if (!c.eat(']')) {
+                    do {
+                        double v;
+                        if (!c.number(v)) return false;
+                        samples.push_back(v);
+                    } while (c.eat(','));
+                    if (!c.eat(']')) return false;
+                }
+            } while (c.eat(','));
+            if (!c.eat('}')) return false;
+        } else if (key == "drift") {
+            if (!c.eat('{')) return false;
+            if (c.eat('}')) continue;
+            do {
+                std::string name;
+                double pct;
+                if (!c.string(name) || !c.eat(':') || !c.number(pct)) return false;
+                if (drift) (*drift)[name] = pct;
+            } while (c.eat(','));
+            if (!c.eat('}')) return false;
+        } else {
+            return false;
+        }
+    } while (c.eat(','));
+    return c.eat('}') && unit == "ns/op";
+}
+
+}  // namespace perf
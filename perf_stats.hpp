@@ -0,0 +1,37 @@
+#pragma once
+#include <map>
+#include <string>
+#include <vector>
+
+// Statistics and result files for `make perf-check`.
+namespace perf {
+
+struct MannWhitney {
+    double u = 0.0;        // U statistic of the current sample
+    double z = 0.0;        // normal approximation, tie-corrected
+    double p_greater = 1;  // one-sided p-value that current > baseline
+};
+
+// Mann-Whitney U test of `current` against `baseline`. Ranks are pooled with
+// ties averaged; with fewer than two samples on either side p_greater is 1.
+MannWhitney mann_whitney(const std::vector<double>& baseline, const std::vector<double>& current);
+
+double median(std::vector<double> v);
+
+// Run-to-run drift in percent: the spread between the medians of `blocks`
+// consecutive groups of samples, relative to the overall median. It
+// captures slow periods of the machine that last many runs.
+double block_drift(const std::vector<double>& samples, int blocks = 4);
+
+// Scenario name → per-run samples (ns/op)
+using Results = std::map<std::string, std::vector<double>>;
+// Scenario name → block_drift() of its samples
+using Drift = std::map<std::string, double>;
+
+// JSON layout: {"unit": "ns/op", "scenarios": {"add": [12.1, ...], ...},
+//               "drift": {"add": 3.2, ...}}; drift is omitted when empty
+bool write_json(const std::string& path, const Results& results, const Drift& drift = {});
+// Reads files written by write_json; false if missing or malformed
+bool read_json(const std::string& path, Results& results, Drift* drift = nullptr);
+
+}  // namespace perf
@@ -0,0 +1,147 @@
+#include "protocol.hpp"
+
+namespace proto {
+
+namespace {
+void header(uint8_t* p, size_t length, MsgType type) {
+    std::memset(p, 0, length);
+    store<uint16_t>(p, static_cast<uint16_t>(length));
+    p[2] = static_cast<uint8_t>(type);
+}
+
+size_t expected_size(MsgType type) {
+    switch (type) {
+        case MsgType::NewOrder: return NEW_ORDER_SIZE;
+        case MsgType::Cancel: return CANCEL_SIZE;
+        case MsgType::Modify: return MODIFY_SIZE;
+        case MsgType::Market: return MARKET_SIZE;
+        default: return 0;
+    }
+}
+}  // namespace
+
+size_t encode_new_order(uint8_t* p, bool is_bid, double price, int32_t qty,
+                        uint32_t owner, int64_t expire_ns) {
+    header(p, NEW_ORDER_SIZE, MsgType::NewOrder);
+    p[4] = is_bid ? 1 : 0;
+    store<uint32_t>(p + 8, owner);
+    store<int32_t>(p + 12, qty);
+    store<double>(p + 16, price);
+    store<int64_t>(p + 24, expire_ns);
+    return NEW_ORDER_SIZE;
+}
+
+size_t encode_cancel(uint8_t* p, uint64_t order_id) {
+    header(p, CANCEL_SIZE, MsgType::Cancel);
+    store<uint64_t>(p + 8, order_id);
+    return CANCEL_SIZE;
+}
+
+size_t encode_modify(uint8_t* p, uint64_t order_id, double price, int32_t qty) {
+    header(p, MODIFY_SIZE, MsgType::Modify);
+    store<int32_t>(p + 4, qty);
+    store<uint64_t>(p + 8, order_id);
+    store<double>(p + 16, price);
+    return MODIFY_SIZE;
+}
+
+size_t encode_market(uint8_t* p, bool is_bid, int32_t qty) {
+    header(p, MARKET_SIZE, MsgType::Market);
+    p[4] = is_bid ? 1 : 0;
+    store<int32_t>(p + 8, qty);
+    return MARKET_SIZE;
+}
+
+size_t encode_ack(uint8_t* p, MsgType request, AckStatus status, uint64_t order_id) {
+    header(p, ACK_SIZE, MsgType::Ack);
+    p[4] = static_cast<uint8_t>(request);
+    p[5] = static_cast<uint8_t>(status);
+    store<uint64_t>(p + 8, order_id);
+    return ACK_SIZE;
+}
+
+size_t encode_fill(uint8_t* p, const Trade& trade) {
+    header(p, FILL_SIZE, MsgType::Fill);
+    store<int32_t>(p + 4, trade.qty);
+    store<uint64_t>(p + 8, trade.buyer_id);
+    store<uint64_t>(p + 16, trade.seller_id);
+    store<double>(p + 24, trade.price);
+    return FILL_SIZE;
+}
+
+Applied apply(OrderBook& book, const uint8_t* msg) {
+    const MsgType type = msg_type(msg);
+    if (msg_length(msg) != expected_size(type)) return {};
+    switch (type) {
+        case MsgType::NewOrder: {
+            NewOrderView m{msg};
+            const uint64_t id = m.expire_ns() != 0
+                ? book.add_limit(m.price(), m.qty(), m.is_bid(),
+                                 std::chrono::nanoseconds(m.expire_ns()), m.owner())
+                : book.add_limit(m.price(), m.qty(), m.is_bid(), m.owner());
+            return {id != 0, id};
+        }
+        case MsgType::Cancel: {
+            CancelView m{msg};
+            return {book.cancel(m.order_id()), m.order_id()};
+        }
+        case MsgType::Modify: {
+            ModifyView m{msg};
+            return {book.modify(m.order_id(), m.price(), m.qty()), m.order_id()};
+        }
+        case MsgType::Market: {
+            MarketView m{msg};
+            const uint64_t id = book.add_market(m.qty(), m.is_bid());
+            return {id != 0, id};
+        }
+        default:
+            return {};  // expected_size() is 0 for other types
+    }
+}
+
+}  // namespace proto
+
+OrderEntrySession::OrderEntrySession(OrderBook& b, size_t out_capacity) : book(b), out(out_capacity) {
+    book.add_listener(this);
+}
+
+OrderEntrySession::~OrderEntrySession() { book.remove_listener(this); }
+
+uint8_t* OrderEntrySession::reserve_out(size_t n) {
+    // Grows only if a single batch produces more than the preallocated space
+    if (out_len + n > out.size()) out.resize(std::max(out.size() * 2, out_len + n));
+    uint8_t* p = out.data() + out_len;
+    out_len += n;
+    return p;
+}
+
+void OrderEntrySession::on_trade(const Trade& trade) {
+    // Trades from other sessions, uncross() or direct calls are not ours
+    if (in_command) proto::encode_fill(reserve_out(proto::FILL_SIZE), trade);
+}
+
+size_t OrderEntrySession::process(const uint8_t* data, size_t len) {
+    size_t pos = 0;
+    while (!failed && len - pos >= proto::HEADER_SIZE) {
+        const uint8_t* msg = data + pos;
+        const size_t length = proto::msg_length(msg);
+        const proto::MsgType type = proto::msg_type(msg);
+        if (length < proto::HEADER_SIZE) {
+            failed = true;  // cannot resynchronize on a corrupt length
+            break;
+        }
+        if (len - pos < length) break;  // partial message, wait for more bytes
+        pos += length;
+
+        // The ack goes ahead of the fills on_trade() appends while the book
+        // works; its slot is held by offset, as a fill may grow the buffer
+        const size_t ack_at = out_len;
+        reserve_out(proto::ACK_SIZE);
+        in_command = true;
+        const proto::Applied r = proto::apply(book, msg);
+        in_command = false;
+        const proto::AckStatus status = r.accepted ? proto::AckStatus::Accepted : proto::AckStatus::Rejected;
+        proto::encode_ack(out.data() + ack_at, type, status, r.order_id);
+    }
+    return pos;
+}
@@ -0,0 +1,177 @@
+#pragma once
+#include "orderbook.hpp"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+// Fixed-layout little-endian binary order-entry protocol.
+//
+// Every message starts with a 4-byte header: uint16 total length, uint8 type,
+// uint8 reserved. Bodies use naturally aligned fixed offsets, so a decoder
+// reads fields in place from the receive buffer (the *View types) and an
+// encoder writes them in place into the send buffer.
+//
+//   NewOrder  32B  side u8 @4, owner u32 @8, qty i32 @12, price f64 @16,
+//                  expire_ns i64 @24 (0 = good till cancel)
+//   Cancel    16B  order_id u64 @8
+//   Modify    24B  qty i32 @4, order_id u64 @8, price f64 @16
+//   Market    16B  side u8 @4, qty i32 @8
+//   Ack       16B  request type u8 @4, status u8 @5, order_id u64 @8
+//   Fill      32B  qty i32 @4, buyer_id u64 @8, seller_id u64 @16, price f64 @24
+namespace proto {
+
+enum class MsgType : uint8_t {
+    NewOrder = 'N',
+    Cancel = 'X',
+    Modify = 'M',
+    Market = 'K',
+    Ack = 'A',
+    Fill = 'F',
+};
+
+enum class AckStatus : uint8_t {
+    Accepted = 0,
+    Rejected = 1,
+};
+
+constexpr size_t HEADER_SIZE = 4;
+constexpr size_t NEW_ORDER_SIZE = 32;
+constexpr size_t CANCEL_SIZE = 16;
+constexpr size_t MODIFY_SIZE = 24;
+constexpr size_t MARKET_SIZE = 16;
+constexpr size_t ACK_SIZE = 16;
+constexpr size_t FILL_SIZE = 32;
+// Largest inbound order-entry message (NewOrder)
+constexpr size_t MAX_REQUEST_SIZE = NEW_ORDER_SIZE;
+
+// Wire order is little-endian; a no-op on little-endian hosts
+template <class T>
+inline T to_wire_order(T v) {
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    uint8_t bytes[sizeof(T)];
+    std::memcpy(bytes, &v, sizeof(T));
+    std::reverse(bytes, bytes + sizeof(T));
+    std::memcpy(&v, bytes, sizeof(T));
+#endif
+    return v;
+}
+
+template <class T>
+inline T load(const uint8_t* p) {
+    T v;
+    std::memcpy(&v, p, sizeof(T));
+    return to_wire_order(v);
+}
+
+template <class T>
+inline void store(uint8_t* p, T v) {
+    v = to_wire_order(v);
+    std::memcpy(p, &v, sizeof(T));
+}
+
+inline uint16_t msg_length(const uint8_t* p) { return load<uint16_t>(p); }
+inline MsgType msg_type(const uint8_t* p) { return static_cast<MsgType>(p[2]); }
+
+// In-place views over a message in a buffer; no bytes are copied
+struct NewOrderView {
+    const uint8_t* p;
+    bool is_bid() const { return p[4] != 0; }
+    uint32_t owner() const { return load<uint32_t>(p + 8); }
+    int32_t qty() const { return load<int32_t>(p + 12); }
+    double price() const { return load<double>(p + 16); }
+    int64_t expire_ns() const { return load<int64_t>(p + 24); }
+};
+
+struct CancelView {
+    const uint8_t* p;
+    uint64_t order_id() const { return load<uint64_t>(p + 8); }
+};
+
+struct ModifyView {
+    const uint8_t* p;
+    int32_t qty() const { return load<int32_t>(p + 4); }
+    uint64_t order_id() const { return load<uint64_t>(p + 8); }
+    double price() const { return load<double>(p + 16); }
+};
+
+struct MarketView {
+    const uint8_t* p;
+    bool is_bid() const { return p[4] != 0; }
+    int32_t qty() const { return load<int32_t>(p + 8); }
+};
+
+struct AckView {
+    const uint8_t* p;
+    MsgType request() const { return static_cast<MsgType>(p[4]); }
+    AckStatus status() const { return static_cast<AckStatus>(p[5]); }
+    uint64_t order_id() const { return load<uint64_t>(p + 8); }
+};
+
+struct FillView {
+    const uint8_t* p;
+    int32_t qty() const { return load<int32_t>(p + 4); }
+    uint64_t buyer_id() const { return load<uint64_t>(p + 8); }
+    uint64_t seller_id() const { return load<uint64_t>(p + 16); }
+    double price() const { return load<double>(p + 24); }
+};
+
+// Encoders write one message at p (which must have room) and return its size
+size_t encode_new_order(uint8_t* p, bool is_bid, double price, int32_t qty,
+                        uint32_t owner = 0, int64_t expire_ns = 0);
+size_t encode_cancel(uint8_t* p, uint64_t order_id);
+size_t encode_modify(uint8_t* p, uint64_t order_id, double price, int32_t qty);
+size_t encode_market(uint8_t* p, bool is_bid, int32_t qty);
+size_t encode_ack(uint8_t* p, MsgType request, AckStatus status, uint64_t order_id);
+size_t encode_fill(uint8_t* p, const Trade& trade);
+
+// Result of applying one order-entry message. order_id is the new order's id
+// for NewOrder and Market (0 when rejected), the target order for Cancel and
+// Modify, and 0 for a message of the wrong length or an unknown type.
+struct Applied {
+    bool accepted = false;
+    uint64_t order_id = 0;
+};
+
+// Decodes one complete order-entry message and applies it to the book. The
+// single decode-and-dispatch path behind OrderEntrySession, cmdlog::apply()
+// and the gateway.
+Applied apply(OrderBook& book, const uint8_t* msg);
+
+}  // namespace proto
+
+// Decodes inbound order-entry messages straight from a receive buffer,
+// applies them to an OrderBook and encodes one Ack per request followed by a
+// Fill per resulting trade into a reusable outbound buffer. The session
+// listens to the book for trades, so fills do not depend on the book
+// retaining its trade history. Only trades caused by this session's own
+// commands are encoded.
+class OrderEntrySession : public BookListener {
+    OrderBook& book;
+    std::vector<uint8_t> out;
+    size_t out_len = 0;
+    bool failed = false;
+    bool in_command = false;  // set while process() applies a message
+
+    uint8_t* reserve_out(size_t n);
+
+public:
+    // Registers as a listener of the book until destroyed
+    explicit OrderEntrySession(OrderBook& book, size_t out_capacity = 1 << 16);
+    ~OrderEntrySession() override;
+    OrderEntrySession(const OrderEntrySession&) = delete;
+    OrderEntrySession& operator=(const OrderEntrySession&) = delete;
+
+    void on_trade(const Trade& trade) override;
+
+    // Handles every complete message in [data, data + len) and returns the
+    // bytes consumed; a trailing partial message is left for the next call.
+    // A malformed header stops decoding and sets protocol_error().
+    size_t process(const uint8_t* data, size_t len);
+
+    const uint8_t* out_data() const { return out.data(); }
+    size_t out_size() const { return out_len; }
+    void clear_out() { out_len = 0; }
+    bool protocol_error() const { return failed; }
+};
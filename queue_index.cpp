@@ -0,0 +1,25 @@
+#include "queue_index.hpp"
+
+QueueIndex::QueueIndex(size_t capacity) : qty(capacity + 1, 0), count(capacity + 1, 0) {}
+
+uint32_t QueueIndex::push(int64_t order_qty) {
+    const uint32_t slot = next++;
+    add(slot, order_qty, 1);
+    return slot;
+}
+
+void QueueIndex::add(uint32_t slot, int64_t dqty, int32_t dcount) {
+    for (size_t i = slot + 1; i < qty.size(); i += i & (~i + 1)) {
+        qty[i] += dqty;
+        count[i] += dcount;
+    }
+}
+
+QueuePosition QueueIndex::ahead(uint32_t slot) const {
+    QueuePosition p;
+    for (size_t i = slot; i > 0; i -= i & (~i + 1)) {
+        p.qty_ahead += qty[i];
+        p.orders_ahead += static_cast<size_t>(count[i]);
+    }
+    return p;
+}
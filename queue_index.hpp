@@ -0,0 +1,36 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// What rests ahead of an order at its price level
+struct QueuePosition {
+    int64_t qty_ahead = 0;
+    size_t orders_ahead = 0;
+};
+
+// Fenwick trees of quantity and order count over a level's insertion
+// sequence. Slot i belongs to the i-th order to join the level and drops to
+// zero once it leaves, so the prefix before an order's slot is what is
+// ahead of it in time priority. push() fails once every slot has been used;
+// the owner then rebuilds a compacted index from the live orders.
+class QueueIndex {
+public:
+    explicit QueueIndex(size_t capacity);
+
+    bool full() const { return next == qty.size() - 1; }
+    // Takes the next slot; the caller checks full() first
+    uint32_t push(int64_t order_qty);
+    // Quantity change of a live order; leave() when it is gone
+    void reduce(uint32_t slot, int64_t by) { add(slot, -by, 0); }
+    void leave(uint32_t slot, int64_t remaining_qty) { add(slot, -remaining_qty, -1); }
+    // Sums over the slots before this one, O(log capacity)
+    QueuePosition ahead(uint32_t slot) const;
+
+private:
+    std::vector<int64_t> qty;    // 1-based trees
+    std::vector<int32_t> count;
+    uint32_t next = 0;
+
+    void add(uint32_t slot, int64_t dqty, int32_t dcount);
+};
@@ -0,0 +1,102 @@
+#include "command_log.hpp"
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+
+namespace {
+
+void usage() {
+    std::cerr << "usage: replay FILE [--paced] [--speed X] [--no-latency] [--counters] [--checksum N]\n"
+                 "  --paced       hold each command until its recorded time offset\n"
+                 "  --speed X     pace multiplier (implies --paced)\n"
+                 "  --no-latency  skip per-command timing, report throughput only\n"
+                 "  --counters    cycles, instructions, cache and branch misses per command kind\n"
+                 "  --checksum N  deterministic timestamps; print the book checksum every N commands\n";
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        usage();
+        return 2;
+    }
+    const char* path = argv[1];
+    cmdlog::ReplayOptions options;
+    for (int i = 2; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--paced") == 0) {
+            options.paced = true;
+        } else if (std::strcmp(argv[i], "--speed") == 0 && i + 1 < argc) {
+            options.paced = true;
+            options.speed = std::atof(argv[++i]);
+        } else if (std::strcmp(argv[i], "--no-latency") == 0) {
+            options.per_command_latency = false;
+        } else if (std::strcmp(argv[i], "--counters") == 0) {
+            options.hardware_counters = true;
+        } else if (std::strcmp(argv[i], "--checksum") == 0 && i + 1 < argc) {
+            options.checksum_interval = static_cast<size_t>(std::atol(argv[++i]));
+        } else {
+            usage();
+            return 2;
+        }
+    }
+
+    cmdlog::MappedFile file;
+    if (!file.open(path)) {
+        std::cerr << "replay: cannot map " << path << "\n";
+        return 1;
+    }
+    cmdlog::Reader header(file.data(), file.size());
+    if (!header.valid()) {
+        std::cerr << "replay: " << path << " is not a command log\n";
+        return 1;
+    }
+
+    OrderBook ob;
+    ob.set_deterministic(options.checksum_interval != 0);
+    cmdlog::ReplayStats stats = cmdlog::replay(ob, file.data(), file.size(), options);
+
+    const double secs = static_cast<double>(stats.elapsed_ns) / 1e9;
+    std::cout << std::fixed << std::setprecision(3);
+    std::cout << "file:       " << path << " (" << file.size() / (1 << 20) << " MiB, "
+              << header.declared_records() << " records declared)\n";
+    std::cout << "commands:   " << stats.commands << " (" << stats.rejected << " rejected)\n";
+    std::cout << "trades:     " << stats.trades << "\n";
+    std::cout << "resting:    " << ob.total_orders() << "\n";
+    std::cout << "state hash: " << std::hex << std::setfill('0') << std::setw(16) << ob.state_hash()
+              << std::dec << std::setfill(' ') << "\n";
+    std::cout << "elapsed:    " << secs << " s";
+    if (options.paced) {
+        std::cout << " (recorded span " << static_cast<double>(stats.recorded_span_ns) / 1e9
+                  << " s at " << options.speed << "x)";
+    }
+    std::cout << "\n";
+    if (secs > 0) {
+        std::cout << "throughput: " << static_cast<double>(stats.commands) / secs / 1e6 << " M cmds/s, "
+                  << static_cast<double>(file.size()) / secs / 1e6 << " MB/s\n";
+    }
+    if (stats.truncated) std::cout << "warning:    stopped at a truncated or corrupt record\n";
+
+    if (options.per_command_latency) stats.latency.print(std::cout, "service");
+    if (options.paced) stats.lag.print(std::cout, "start lag");
+    if (options.hardware_counters) {
+        if (!stats.counters) {
+            std::cout << "counters:   unavailable, " << stats.counters_error << "\n";
+        } else {
+            stats.add_counters.print(std::cout, "add", stats.counters_present);
+            stats.match_counters.print(std::cout, "match", stats.counters_present);
+            stats.cancel_counters.print(std::cout, "cancel", stats.counters_present);
+            stats.modify_counters.print(std::cout, "modify", stats.counters_present);
+        }
+    }
+    if (options.checksum_interval) {
+        std::cout << std::hex << std::setfill('0');
+        for (size_t i = 0; i < stats.checksums.size(); ++i) {
+            std::cout << "checksum:   " << std::dec << (i + 1) * options.checksum_interval << " "
+                      << std::hex << std::setw(16) << stats.checksums[i] << "\n";
+        }
+        std::cout << "checksum:   final " << std::setw(16) << ob.checksum() << std::dec << std::setfill(' ') << "\n";
+    }
+    return stats.truncated ? 1 : 0;
+}
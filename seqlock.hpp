@@ -0,0 +1,58 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+// Single-writer sequence lock.
+//
+// The writer makes the sequence odd, stores the value and makes it even
+// again. A reader copies the value between two loads of the sequence and
+// retries if they differ or are odd. Readers never write shared memory, so
+// any number of them leave the writer's cache lines alone. The value is
+// copied as relaxed atomic words, which keeps a torn read well defined until
+// the sequence check discards it.
+template <class T>
+class SeqLock {
+    static_assert(std::is_trivially_copyable<T>::value, "SeqLock values are copied bytewise");
+    static constexpr size_t WORDS = (sizeof(T) + 7) / 8;
+
+public:
+    // Writer only
+    void store(const T& value) {
+        uint64_t w[WORDS] = {};
+        std::memcpy(w, &value, sizeof(T));
+        const uint64_t s = seq.load(std::memory_order_relaxed);
+        seq.store(s + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        for (size_t i = 0; i < WORDS; ++i) words[i].store(w[i], std::memory_order_relaxed);
+        seq.store(s + 2, std::memory_order_release);
+    }
+
+    // One attempt; false if a store was in progress
+    bool try_load(T& out) const {
+        const uint64_t s0 = seq.load(std::memory_order_acquire);
+        if (s0 & 1) return false;
+        uint64_t w[WORDS];
+        for (size_t i = 0; i < WORDS; ++i) w[i] = words[i].load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (seq.load(std::memory_order_relaxed) != s0) return false;
+        std::memcpy(&out, w, sizeof(T));
+        return true;
+    }
+
+    // Retries until a consistent copy is taken; returns the attempts used
+    unsigned load(T& out) const {
+        unsigned attempts = 1;
+        while (!try_load(out)) ++attempts;
+        return attempts;
+    }
+
+    // Completed stores so far
+    uint64_t version() const { return seq.load(std::memory_order_acquire) / 2; }
+
+private:
+    alignas(64) std::atomic<uint64_t> seq{0};
+    alignas(64) std::atomic<uint64_t> words[WORDS] = {};
+};
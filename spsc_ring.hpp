@@ -0,0 +1,91 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Bounded single-producer single-consumer ring.
+//
+// Each side owns one cache line: its own index plus a cached copy of the
+// other side's index, refreshed only when the ring looks full (producer) or
+// empty (consumer). A push is a copy and one release store with no shared
+// read-modify-write.
+template <class T>
+class SpscRing {
+public:
+    // Capacity is rounded up to a power of two
+    explicit SpscRing(size_t capacity) {
+        size_t cap = 2;
+        while (cap < capacity) cap <<= 1;
+        slots.resize(cap);
+        mask = cap - 1;
+    }
+    SpscRing(const SpscRing&) = delete;
+    SpscRing& operator=(const SpscRing&) = delete;
+
+    // Producer only; false when full
+    bool try_push(const T& value) {
+        T* slot = claim();
+        if (!slot) return false;
+        *slot = value;
+        publish();
+        return true;
+    }
+
+    // Producer only: the next free slot, to be written in place, or nullptr
+    // when full. publish() hands it to the consumer.
+    T* claim() {
+        const uint64_t t = tail.load(std::memory_order_relaxed);
+        if (t - cached_head > mask) {
+            cached_head = head.load(std::memory_order_acquire);
+            if (t - cached_head > mask) return nullptr;
+        }
+        return &slots[t & mask];
+    }
+    void publish() { tail.store(tail.load(std::memory_order_relaxed) + 1, std::memory_order_release); }
+
+    // Consumer only: calls f(const T&) on up to max entries in place and
+    // frees their slots with a single store. Returns the number consumed.
+    template <class F>
+    size_t consume(size_t max, F&& f) {
+        const uint64_t h = head.load(std::memory_order_relaxed);
+        if (cached_tail == h) {
+            cached_tail = tail.load(std::memory_order_acquire);
+            if (cached_tail == h) return 0;
+        }
+        const uint64_t avail = cached_tail - h;
+        const size_t n = avail < max ? static_cast<size_t>(avail) : max;
+        for (size_t i = 0; i < n; ++i) f(slots[(h + i) & mask]);
+        head.store(h + n, std::memory_order_release);
+        return n;
+    }
+
+    // Consumer only: the longest run of queued entries that is contiguous in
+    // memory (it stops at the wrap point); release(n) frees the first n
+    size_t peek(const T*& first) {
+        const uint64_t h = head.load(std::memory_order_relaxed);
+        if (cached_tail == h) {
+            cached_tail = tail.load(std::memory_order_acquire);
+            if (cached_tail == h) return 0;
+        }
+        const size_t start = static_cast<size_t>(h & mask);
+        const size_t avail = static_cast<size_t>(cached_tail - h);
+        first = &slots[start];
+        return avail < slots.size() - start ? avail : slots.size() - start;
+    }
+    void release(size_t n) { head.store(head.load(std::memory_order_relaxed) + n, std::memory_order_release); }
+
+    size_t capacity() const { return mask + 1; }
+    // Approximate when called concurrently with either side
+    size_t size() const {
+        return static_cast<size_t>(tail.load(std::memory_order_acquire) - head.load(std::memory_order_acquire));
+    }
+
+private:
+    std::vector<T> slots;
+    uint64_t mask = 0;
+    alignas(64) std::atomic<uint64_t> tail{0};  // producer line
+    uint64_t cached_head = 0;
+    alignas(64) std::atomic<uint64_t> head{0};  // consumer line
+    uint64_t cached_tail = 0;
+};
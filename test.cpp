@@ -1,3 +1,4 @@
+#include "order_flow.hpp"
 #include "orderbook.hpp"
 #include <cassert>
 #include <iostream>
@@ -229,7 +230,7 @@ void test_benchmark() {
     OrderBook ob;
     
     // Benchmark insertions
-    ob.benchmark(100000);
+    run_flow_benchmark(ob, 100000);
     
     std::cout << "Active orders: " << ob.total_orders() << std::endl;
     std::cout << "Total trades: " << ob.get_trades().size() << std::endl;
@@ -0,0 +1,1730 @@
+#include "command_log.hpp"
+#include "concurrent_book.hpp"
+#include "experiments/soa_level.hpp"
+#include "gateway.hpp"
+#include "journal.hpp"
+#include "md_feed.hpp"
+#include "order_flow.hpp"
+#include "orderbook.hpp"
+#include "order_index.hpp"
+#include "perf_stats.hpp"
+#include "protocol.hpp"
+#include "text_import.hpp"
+#include "top_of_book.hpp"
+#include "trade_log.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cmath>
+#include <cstdio>
+#include <iostream>
+#include <limits>
+#include <thread>
+#include <unistd.h>
+
+// Seeded xorshift64 for the randomized flow tests; rnd(n) is in [0, n)
+struct XorShift {
+    uint64_t x;
+    uint64_t operator()(uint64_t n) {
+        x ^= x << 13;
+        x ^= x >> 7;
+        x ^= x << 17;
+        return x % n;
+    }
+};
+
+void test_auction_uncross() {
+    std::cout << "\n=== Test: Auction Uncross ===" << std::endl;
+    OrderBook ob;
+    ob.begin_auction();
+
+    uint64_t bid1 = ob.add_limit(101.0, 50, true);
+    uint64_t bid2 = ob.add_limit(100.0, 50, true);
+    uint64_t ask1 = ob.add_limit(99.0, 30, false);
+    uint64_t ask2 = ob.add_limit(100.0, 40, false);
+    ob.add_limit(102.0, 50, false);
+
+    // Crossed orders accumulate without trading
+    assert(ob.total_orders() == 5);
+    assert(ob.get_trades().empty());
+
+    // Volume at 99 = 30, at 100 = 70, at 101 = 50 -> clears at 100
+    AuctionResult indicative = ob.indicative_uncross();
+    assert(indicative.price == 100.0);
+    assert(indicative.qty == 70);
+
+    AuctionResult result = ob.uncross();
+    assert(result.price == 100.0);
+    assert(result.qty == 70);
+    assert(!ob.auction_active());
+
+    const auto& trades = ob.get_trades();
+    assert(trades.size() == 3);
+    int traded = 0;
+    for (const auto& t : trades) {
+        assert(t.price == 100.0);
+        traded += t.qty;
+    }
+    assert(traded == 70);
+    assert(trades[0].buyer_id == bid1 && trades[0].seller_id == ask1);
+    assert(trades[1].buyer_id == bid1 && trades[1].seller_id == ask2);
+    assert(trades[2].buyer_id == bid2 && trades[2].seller_id == ask2);
+
+    // 30 left on bid2 @ 100 and the untouched ask @ 102
+    assert(ob.total_orders() == 2);
+
+    // Continuous matching resumes
+    ob.add_limit(100.0, 30, false);
+    assert(ob.get_trades().size() == 4);
+    assert(ob.total_orders() == 1);
+
+    std::cout << "✓ Auction uncrosses at max-volume price\n";
+}
+
+void test_auction_no_cross() {
+    std::cout << "\n=== Test: Auction Without Cross ===" << std::endl;
+    OrderBook ob;
+    ob.begin_auction();
+
+    ob.add_limit(99.0, 10, true);
+    ob.add_limit(100.0, 10, false);
+
+    // Market orders are not accepted during the call phase
+    assert(ob.add_market(10, true) == 0);
+
+    AuctionResult result = ob.uncross();
+    assert(result.qty == 0);
+    assert(result.price == 0.0);
+    assert(ob.get_trades().empty());
+    assert(ob.total_orders() == 2);
+
+    std::cout << "✓ Uncross is a no-op when the book does not cross\n";
+}
+
+void test_auction_tiebreak() {
+    std::cout << "\n=== Test: Auction Price Tie-Break ===" << std::endl;
+
+    // Same volume and surplus at 100 and 101: buy surplus pushes price up
+    OrderBook buy_side;
+    buy_side.begin_auction();
+    buy_side.add_limit(101.0, 150, true);
+    buy_side.add_limit(100.0, 100, false);
+    AuctionResult up = buy_side.uncross();
+    assert(up.qty == 100);
+    assert(up.price == 101.0);
+
+    // Sell surplus keeps it at the lower price
+    OrderBook sell_side;
+    sell_side.begin_auction();
+    sell_side.add_limit(101.0, 100, true);
+    sell_side.add_limit(100.0, 150, false);
+    AuctionResult down = sell_side.uncross();
+    assert(down.qty == 100);
+    assert(down.price == 100.0);
+
+    std::cout << "✓ Ties resolved by market pressure\n";
+}
+
+void test_auction_large() {
+    std::cout << "\n=== Test: Large Closing Auction ===" << std::endl;
+    OrderBook ob;
+    ob.begin_auction();
+
+    const int N = 200000;
+    for (int i = 0; i < N; ++i) {
+        double price = 95.0 + (i % 100) * 0.1;
+        ob.add_limit(price, 100, i % 2 == 0);
+    }
+    assert(ob.total_orders() == static_cast<size_t>(N));
+
+    auto start = std::chrono::high_resolution_clock::now();
+    AuctionResult result = ob.uncross();
+    auto end = std::chrono::high_resolution_clock::now();
+
+    int64_t traded = 0;
+    for (const auto& t : ob.get_trades()) traded += t.qty;
+    assert(traded == result.qty);
+    assert(result.qty > 0);
+
+    std::cout << "Uncrossed " << N << " orders @ " << result.price << " x " << result.qty
+              << " in " << std::chrono::duration_cast<std::chrono::microseconds>(end - start).count() / 1e3
+              << " ms" << std::endl;
+    std::cout << "✓ Large auction completes\n";
+}
+
+void test_pro_rata_allocation() {
+    std::cout << "\n=== Test: Pro-Rata Allocation ===" << std::endl;
+    ProRataOrderBook ob;
+
+    uint64_t small = ob.add_limit(100.0, 100, false);
+    uint64_t large = ob.add_limit(100.0, 300, false);
+
+    // 100 shared in proportion 1:3
+    ob.add_limit(100.0, 100, true);
+    const auto& trades = ob.get_trades();
+    assert(trades.size() == 2);
+    assert(trades[0].seller_id == small && trades[0].qty == 25);
+    assert(trades[1].seller_id == large && trades[1].qty == 75);
+    assert(ob.total_orders() == 2);
+
+    // Sweeping the rest of the level fills both completely
+    ob.add_limit(100.0, 300, true);
+    assert(ob.total_orders() == 0);
+
+    std::cout << "✓ Pro-rata splits by resting size\n";
+}
+
+void test_pro_rata_remainder() {
+    std::cout << "\n=== Test: Pro-Rata Remainder ===" << std::endl;
+    ProRataOrderBook ob;
+
+    uint64_t first = ob.add_limit(100.0, 1, false);
+    uint64_t second = ob.add_limit(100.0, 1, false);
+    ob.add_limit(100.0, 1, false);
+
+    // Every pro-rata share rounds down to zero; leftover lots go in time order
+    ob.add_limit(100.0, 2, true);
+    const auto& trades = ob.get_trades();
+    assert(trades.size() == 2);
+    assert(trades[0].seller_id == first && trades[0].qty == 1);
+    assert(trades[1].seller_id == second && trades[1].qty == 1);
+    assert(ob.total_orders() == 1);
+
+    std::cout << "✓ Rounding remainder allocated FIFO\n";
+}
+
+void test_top_order_pro_rata() {
+    std::cout << "\n=== Test: Top Order Then Pro-Rata ===" << std::endl;
+    TopOrderProRataOrderBook ob;
+
+    uint64_t top = ob.add_limit(100.0, 100, false);
+    uint64_t a = ob.add_limit(100.0, 200, false);
+    uint64_t b = ob.add_limit(100.0, 200, false);
+
+    // Top order fills first, the remaining 100 is split evenly
+    ob.add_limit(100.0, 200, true);
+    const auto& trades = ob.get_trades();
+    assert(trades.size() == 3);
+    assert(trades[0].seller_id == top && trades[0].qty == 100);
+    assert(trades[1].seller_id == a && trades[1].qty == 50);
+    assert(trades[2].seller_id == b && trades[2].qty == 50);
+    assert(ob.total_orders() == 2);
+
+    std::cout << "✓ Top order priority before pro-rata\n";
+}
+
+void test_gtt_expiry() {
+    std::cout << "\n=== Test: Good-Till-Time Expiry ===" << std::endl;
+    using std::chrono::milliseconds;
+    OrderBook ob;
+    ob.advance_time(milliseconds(1000));
+
+    uint64_t early = ob.add_limit(99.0, 10, true, milliseconds(1500));
+    uint64_t late = ob.add_limit(98.0, 10, true, milliseconds(5000));
+    uint64_t filled = ob.add_limit(101.0, 10, false, milliseconds(1200));
+    ob.add_limit(97.0, 10, true);  // no expiry
+    assert(early && late && filled);
+    assert(ob.total_orders() == 4);
+
+    // Expiry must be in the future
+    assert(ob.add_limit(99.0, 10, true, milliseconds(1000)) == 0);
+
+    // Fill the GTT ask before it expires; its timer must be a no-op
+    ob.add_limit(101.0, 10, true);
+    assert(ob.total_orders() == 3);
+
+    assert(ob.advance_time(milliseconds(1499)) == 0);
+    assert(ob.total_orders() == 3);
+    assert(ob.advance_time(milliseconds(1500)) == 1);
+    assert(!ob.cancel(early));
+    assert(ob.total_orders() == 2);
+
+    // A large jump expires the rest; the plain limit order stays
+    assert(ob.advance_time(std::chrono::hours(24)) == 1);
+    assert(!ob.cancel(late));
+    assert(ob.total_orders() == 1);
+
+    std::cout << "✓ GTT orders expire on advance_time\n";
+}
+
+void test_gtt_many() {
+    std::cout << "\n=== Test: GTT Expiry At Scale ===" << std::endl;
+    using std::chrono::microseconds;
+    OrderBook ob;
+
+    // Wall-clock scale timestamps, expiries spread over ~10 minutes
+    const auto base = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::hours(480000));
+    ob.advance_time(base);
+    const int N = 100000;
+    for (int i = 0; i < N; ++i) {
+        double price = 90.0 + (i % 50) * 0.1;
+        ob.add_limit(price, 10, true, base + microseconds(1 + (i * 7919LL) % 600000000));
+    }
+    assert(ob.total_orders() == static_cast<size_t>(N));
+
+    // Expire in steps and check nothing fires early
+    size_t total = 0;
+    for (int step = 1; step <= 10; ++step) {
+        auto now = base + microseconds(step * 60000000LL);
+        total += ob.advance_time(now);
+        size_t expected = 0;
+        for (int i = 0; i < N; ++i) {
+            if (1 + (i * 7919LL) % 600000000 <= step * 60000000LL) ++expected;
+        }
+        assert(total == expected);
+    }
+    assert(total == static_cast<size_t>(N));
+    assert(ob.total_orders() == 0);
+
+    std::cout << "✓ Expired " << total << " orders without early fires\n";
+}
+
+void test_cancel_all_owner() {
+    std::cout << "\n=== Test: Cancel All By Owner ===" << std::endl;
+    OrderBook ob;
+
+    ob.add_limit(99.0, 10, true, 7);
+    ob.add_limit(99.0, 10, true, 8);
+    ob.add_limit(98.0, 10, true, 7);
+    ob.add_limit(101.0, 10, false, 7);
+    uint64_t other = ob.add_limit(102.0, 10, false, 8);
+    assert(ob.total_orders() == 5);
+
+    assert(ob.cancel_all(7) == 3);
+    assert(ob.total_orders() == 2);
+    assert(ob.cancel_all(7) == 0);
+    assert(ob.cancel_all(42) == 0);
+
+    // 98 bid and 101 ask levels are gone: a sell at 98 rests, a buy at 101 rests
+    ob.add_limit(98.0, 5, false, 9);
+    assert(ob.get_trades().size() == 1);  // hits owner 8's bid at 99
+    assert(ob.get_trades()[0].price == 99.0);
+    ob.add_limit(101.0, 5, true, 9);
+    assert(ob.get_trades().size() == 1);
+
+    assert(ob.cancel(other));
+    std::cout << "✓ Owner orders cancelled in one pass\n";
+}
+
+void test_cancel_side() {
+    std::cout << "\n=== Test: Cancel Side ===" << std::endl;
+    OrderBook ob;
+
+    for (int i = 0; i < 100; ++i) {
+        ob.add_limit(90.0 + (i % 10), 10, true, i % 3);
+        ob.add_limit(110.0 + (i % 10), 10, false, i % 3);
+    }
+    assert(ob.total_orders() == 200);
+
+    assert(ob.cancel_side(true) == 100);
+    assert(ob.total_orders() == 100);
+
+    // Owner lists no longer hold the cancelled bids
+    assert(ob.cancel_all(0) == 34);
+    assert(ob.total_orders() == 66);
+
+    // Market sell finds no bids
+    ob.add_market(10, false);
+    assert(ob.get_trades().empty());
+
+    std::cout << "✓ Side cancelled and owner lists stay consistent\n";
+}
+
+void test_disconnect_large() {
+    std::cout << "\n=== Test: Large Disconnect ===" << std::endl;
+    OrderBook ob;
+
+    const int N = 50000;
+    for (int i = 0; i < N; ++i) {
+        ob.add_limit(90.0 + (i % 500) * 0.01, 10, true, 1);
+        if (i % 10 == 0) ob.add_limit(80.0 + (i % 7), 10, true, 2);
+    }
+
+    auto start = std::chrono::high_resolution_clock::now();
+    size_t cancelled = ob.cancel_all(1);
+    auto end = std::chrono::high_resolution_clock::now();
+
+    assert(cancelled == static_cast<size_t>(N));
+    assert(ob.total_orders() == static_cast<size_t>(N / 10));
+
+    std::cout << "Cancelled " << cancelled << " orders in "
+              << std::chrono::duration_cast<std::chrono::microseconds>(end - start).count() / 1e3
+              << " ms" << std::endl;
+    std::cout << "✓ Disconnect cleared in one pass\n";
+}
+
+void test_soa_level() {
+    std::cout << "\n=== Test: SoA Price Level ===" << std::endl;
+    SoaPriceLevel level;
+
+    const int N = 1000;
+    for (int i = 1; i <= N; ++i) level.push_back(i, i, std::chrono::nanoseconds(i));
+    assert(level.size() == static_cast<size_t>(N));
+    assert(level.total_qty() == static_cast<int64_t>(N) * (N + 1) / 2);
+    assert(level.find(N) == N - 1);
+    assert(level.find(N + 1) == -1);
+    assert(level.qty_ahead(3) == 1 + 2 + 3);
+
+    // Pop past the compaction threshold; positions stay relative to the front
+    for (int i = 0; i < 600; ++i) level.pop_front();
+    assert(level.size() == 400);
+    assert(level.id_at(0) == 601);
+    assert(level.find(601) == 0);
+    assert(level.total_qty() == soa::sum_qty_scalar(level.qty_data(), level.size()));
+
+    assert(level.erase(700));
+    assert(!level.erase(700));
+    assert(level.find(701) == 99);
+    level.qty_at(0) -= 1;
+    assert(level.total_qty() == soa::sum_qty_scalar(level.qty_data(), level.size()));
+
+    // Vector and scalar kernels agree on odd lengths
+    for (size_t n = 0; n < 20; ++n) {
+        assert(soa::sum_qty(level.qty_data(), n) == soa::sum_qty_scalar(level.qty_data(), n));
+        assert(soa::find_id(level.id_data(), n, 610) == soa::find_id_scalar(level.id_data(), n, 610));
+    }
+
+    std::cout << "✓ SoA level scans match scalar reference\n";
+}
+
+void test_order_index() {
+    std::cout << "\n=== Test: Paged Order Index ===" << std::endl;
+    OrderIndex index;
+    const uint64_t N = 5 * OrderIndex::PAGE_SIZE + 17;
+
+    for (uint64_t id = 1; id <= N; ++id) index.insert(id, static_cast<OrderHandle>(id * 3));
+    assert(index.size() == N);
+    assert(index.find(1) == 3);
+    assert(index.find(N) == N * 3);
+    assert(index.find(0) == NIL_ORDER);
+    assert(index.find(N + 1) == NIL_ORDER);
+    assert(index.find(1ull << 40) == NIL_ORDER);
+
+    // Drain the oldest pages; the window slides and lookups stay correct
+    for (uint64_t id = 1; id <= 3 * OrderIndex::PAGE_SIZE; ++id) assert(index.erase(id));
+    assert(!index.erase(1));
+    assert(index.find(2) == NIL_ORDER);
+    assert(index.find(3 * OrderIndex::PAGE_SIZE + 1) == (3 * OrderIndex::PAGE_SIZE + 1) * 3);
+    assert(index.size() == N - 3 * OrderIndex::PAGE_SIZE);
+
+    // Re-inserting an id behind the window grows it backwards
+    index.insert(5, 42);
+    assert(index.find(5) == 42);
+    assert(index.erase(5));
+
+    // Overwriting keeps the count
+    index.insert(N, 7);
+    assert(index.find(N) == 7);
+    assert(index.size() == N - 3 * OrderIndex::PAGE_SIZE);
+
+    index.clear();
+    assert(index.size() == 0);
+    assert(index.find(N) == NIL_ORDER);
+    index.insert(N + 100, 1);
+    assert(index.find(N + 100) == 1);
+
+    std::cout << "✓ Paged index tracks ids across page recycling\n";
+}
+
+void test_modify() {
+    std::cout << "\n=== Test: Modify ===" << std::endl;
+    OrderBook ob;
+
+    uint64_t first = ob.add_limit(100.0, 50, false);
+    uint64_t second = ob.add_limit(100.0, 50, false);
+
+    // Size down in place keeps priority
+    assert(ob.modify(first, 100.0, 20));
+    ob.add_limit(100.0, 20, true);
+    assert(ob.get_trades().back().seller_id == first);
+    assert(ob.total_orders() == 1);
+
+    // Size up loses priority; reprice through the spread matches
+    uint64_t third = ob.add_limit(100.0, 10, false);
+    assert(ob.modify(second, 100.0, 60));
+    ob.add_limit(100.0, 10, true);
+    assert(ob.get_trades().back().seller_id == third);
+
+    uint64_t bid = ob.add_limit(99.0, 30, true);
+    assert(ob.modify(bid, 100.0, 30));
+    assert(ob.get_trades().back().buyer_id == bid);
+    assert(ob.get_trades().back().seller_id == second);
+    assert(ob.total_orders() == 1);
+
+    assert(ob.modify(second, 100.0, 0));
+    assert(ob.total_orders() == 0);
+    assert(!ob.modify(second, 100.0, 10));
+
+    std::cout << "✓ Modify keeps or resets priority as expected\n";
+}
+
+void test_protocol_session() {
+    std::cout << "\n=== Test: Binary Order Entry ===" << std::endl;
+    using namespace proto;
+    OrderBook ob;
+    OrderEntrySession session(ob);
+
+    uint8_t in[256];
+    size_t len = 0;
+    len += encode_new_order(in + len, false, 100.0, 50, 7);
+    len += encode_new_order(in + len, true, 100.0, 30, 8);
+    len += encode_modify(in + len, 1, 100.0, 10);
+    len += encode_cancel(in + len, 999);
+    len += encode_market(in + len, true, 5);
+
+    // Feed all but the last 3 bytes: the market order stays pending
+    size_t used = session.process(in, len - 3);
+    assert(used == len - MARKET_SIZE);
+    used += session.process(in + used, len - used);
+    assert(used == len);
+    assert(!session.protocol_error());
+
+    // Expect: ack, ack+fill, ack, reject, ack+fill
+    const uint8_t* out = session.out_data();
+    size_t pos = 0;
+    auto next = [&](MsgType type) {
+        assert(pos + HEADER_SIZE <= session.out_size());
+        assert(msg_type(out + pos) == type);
+        const uint8_t* msg = out + pos;
+        pos += msg_length(msg);
+        return msg;
+    };
+
+    AckView a1{next(MsgType::Ack)};
+    assert(a1.request() == MsgType::NewOrder && a1.status() == AckStatus::Accepted && a1.order_id() == 1);
+    AckView a2{next(MsgType::Ack)};
+    assert(a2.order_id() == 2);
+    FillView f1{next(MsgType::Fill)};
+    assert(f1.buyer_id() == 2 && f1.seller_id() == 1 && f1.qty() == 30 && f1.price() == 100.0);
+    AckView a3{next(MsgType::Ack)};
+    assert(a3.request() == MsgType::Modify && a3.status() == AckStatus::Accepted);
+    AckView a4{next(MsgType::Ack)};
+    assert(a4.request() == MsgType::Cancel && a4.status() == AckStatus::Rejected && a4.order_id() == 999);
+    AckView a5{next(MsgType::Ack)};
+    assert(a5.request() == MsgType::Market && a5.order_id() == 3);
+    FillView f2{next(MsgType::Fill)};
+    assert(f2.qty() == 5 && f2.seller_id() == 1);
+    assert(pos == session.out_size());
+    assert(ob.total_orders() == 1);
+
+    // Wrong length for the type is rejected and skipped; zero length is fatal
+    session.clear_out();
+    uint8_t bad[32] = {};
+    store<uint16_t>(bad, 8);
+    bad[2] = static_cast<uint8_t>(MsgType::Cancel);
+    assert(session.process(bad, 8) == 8);
+    assert(AckView{session.out_data()}.status() == AckStatus::Rejected);
+    store<uint16_t>(bad, 0);
+    assert(session.process(bad, sizeof(bad)) == 0);
+    assert(session.protocol_error());
+
+    // Fills come from the session's listener, not the retained history
+    OrderBook streaming;
+    streaming.set_retain_trades(false);
+    OrderEntrySession live(streaming);
+    uint8_t flow[3 * NEW_ORDER_SIZE];
+    size_t flow_len = encode_new_order(flow, false, 100.0, 5, 1);
+    flow_len += encode_new_order(flow + flow_len, false, 100.5, 5, 1);
+    flow_len += encode_new_order(flow + flow_len, true, 101.0, 8, 2);
+    assert(live.process(flow, flow_len) == flow_len);
+    assert(streaming.get_trades().empty());
+    assert(live.out_size() == 3 * ACK_SIZE + 2 * FILL_SIZE);
+    const uint8_t* fills = live.out_data() + 3 * ACK_SIZE;
+    assert(AckView{fills - ACK_SIZE}.order_id() == 3);
+    assert(FillView{fills}.seller_id() == 1 && FillView{fills}.qty() == 5);
+    assert(FillView{fills + FILL_SIZE}.seller_id() == 2 && FillView{fills + FILL_SIZE}.qty() == 3);
+
+    // Two sessions on one book: each sees only the fills of its own commands,
+    // and trades made outside process() reach neither
+    OrderBook shared;
+    OrderEntrySession maker(shared), taker(shared);
+    uint8_t rest[2 * NEW_ORDER_SIZE];
+    const size_t rest_len = encode_new_order(rest, false, 100.0, 10, 1);
+    assert(maker.process(rest, rest_len) == rest_len);
+    shared.add_limit(99.0, 4, true);
+    shared.add_market(3, false);               // direct call, not a session
+    assert(shared.get_trades().size() == 1);
+    const size_t take_len = encode_new_order(rest, true, 100.0, 6, 2);
+    assert(taker.process(rest, take_len) == take_len);
+    assert(maker.out_size() == ACK_SIZE && AckView{maker.out_data()}.order_id() == 1);
+    assert(taker.out_size() == ACK_SIZE + FILL_SIZE);
+    assert(AckView{taker.out_data()}.order_id() == 4);
+    const FillView own{taker.out_data() + ACK_SIZE};
+    assert(own.buyer_id() == 4 && own.seller_id() == 1 && own.qty() == 6);
+    shared.begin_auction();
+    shared.add_limit(101.0, 2, true);
+    shared.add_limit(101.0, 2, false);
+    assert(shared.uncross().qty > 0);
+    assert(maker.out_size() == ACK_SIZE && taker.out_size() == ACK_SIZE + FILL_SIZE);
+
+    // Non-finite prices are rejected by the book, whichever path they take
+    OrderBook guarded;
+    guarded.add_limit(100.0, 10, true);
+    OrderEntrySession checked(guarded);
+    const double bad_prices[] = {std::numeric_limits<double>::quiet_NaN(),
+                                 std::numeric_limits<double>::infinity(),
+                                 -std::numeric_limits<double>::infinity()};
+    for (double price : bad_prices) {
+        uint8_t msgs[NEW_ORDER_SIZE + MODIFY_SIZE];
+        const size_t n = encode_new_order(msgs, false, price, 5, 0);
+        const size_t m = encode_modify(msgs + n, 1, price, 5);
+        checked.clear_out();
+        assert(checked.process(msgs, n + m) == n + m);
+        assert(checked.out_size() == 2 * ACK_SIZE);
+        assert(AckView{checked.out_data()}.status() == AckStatus::Rejected);
+        assert(AckView{checked.out_data() + ACK_SIZE}.status() == AckStatus::Rejected);
+        assert(!cmdlog::apply(guarded, msgs) && !cmdlog::apply(guarded, msgs + n));
+    }
+    LevelInfo top[4];
+    assert(guarded.total_orders() == 1 && guarded.depth(true, top, 4) == 1 && top[0].qty == 10);
+    assert(guarded.depth(false, top, 4) == 0 && guarded.get_trades().empty());
+
+    std::cout << "✓ Messages decoded in place, acks and fills encoded\n";
+}
+
+// Receiver book must equal the publisher's book level for level
+template <class Levels>
+bool same_levels(const OrderBook& ob, bool is_bid, const Levels& levels) {
+    std::vector<LevelInfo> out(4096);
+    size_t n = ob.depth(is_bid, out.data(), out.size());
+    if (n != levels.size()) return false;
+    size_t i = 0;
+    for (const auto& kv : levels) {
+        const LevelInfo& l = kv.second;
+        if (l.price != out[i].price || l.qty != out[i].qty || l.count != out[i].count) return false;
+        ++i;
+    }
+    return true;
+}
+
+void test_md_feed() {
+    std::cout << "\n=== Test: Multicast Market Data ===" << std::endl;
+    const char* group = "239.255.0.1";
+    const uint16_t port = static_cast<uint16_t>(30000 + getpid() % 20000);
+
+    MdPublisher pub;
+    MdReceiver rx;
+    if (!pub.open(group, port) || !rx.open(group, port)) {
+        std::cout << "(multicast unavailable, skipped)\n";
+        return;
+    }
+
+    OrderBook ob;
+    ob.add_listener(&pub);
+    for (int i = 0; i < 40; ++i) {
+        ob.add_limit(100.0 - i * 0.5, 10 + i, true);
+        ob.add_limit(101.0 + i * 0.5, 10 + i, false);
+    }
+    ob.add_limit(100.0, 5, true);
+    ob.cancel(3);
+    ob.add_market(25, true);  // sweeps two ask levels and part of a third
+    ob.modify(6, 101.25, 7);
+    pub.flush();
+
+    // ~170 events: several datagrams in one sendmmsg
+    assert(pub.datagrams_sent() > 1);
+    assert(pub.send_calls() == 1);
+    assert(rx.poll() == pub.datagrams_sent());
+    assert(rx.synced() && rx.gaps() == 0);
+    assert(rx.trades() == 3);
+    assert(same_levels(ob, true, rx.bids()));
+    assert(same_levels(ob, false, rx.asks()));
+
+    // Lost datagrams mark the receiver stale; level updates are held back
+    pub.close();
+    ob.add_limit(95.0, 3, true);
+    pub.flush();
+    assert(pub.open(group, port));
+    ob.add_limit(94.0, 3, true);
+    pub.flush();
+    rx.poll();
+    assert(!rx.synced() && rx.gaps() == 1);
+    assert(rx.bids().empty());
+
+    // Snapshot resynchronizes; duplicates of the old sequence are ignored
+    MdReceiver late;
+    assert(late.open(group, port));
+    pub.publish_snapshot(ob);
+    rx.poll();
+    late.poll();
+    assert(rx.synced() && same_levels(ob, true, rx.bids()) && same_levels(ob, false, rx.asks()));
+    assert(late.synced() && same_levels(ob, true, late.bids()) && same_levels(ob, false, late.asks()));
+    ob.cancel(5);
+    pub.flush();
+    late.poll();
+    assert(late.gaps() == 0 && same_levels(ob, true, late.bids()));
+
+    // Deeper than the scratch's initial 64 levels: the snapshot still
+    // carries every level of both sides
+    for (int i = 0; i < 150; ++i) {
+        ob.add_limit(80.0 - 0.1 * i, 1 + i % 4, true);
+        ob.add_limit(120.0 + 0.1 * i, 1 + i % 4, false);
+    }
+    pub.flush();
+    MdReceiver deep;
+    assert(deep.open(group, port));
+    pub.publish_snapshot(ob);
+    deep.poll();
+    assert(deep.synced() && deep.bids().size() > 150 && deep.asks().size() > 150);
+    assert(same_levels(ob, true, deep.bids()) && same_levels(ob, false, deep.asks()));
+
+    ob.remove_listener(&pub);
+    std::cout << "✓ " << pub.datagrams_sent() << " datagrams in " << pub.send_calls()
+              << " sendmmsg calls, book rebuilt, gap recovered by snapshot\n";
+}
+
+void test_command_log_replay() {
+    std::cout << "\n=== Test: Command Log Replay ===" << std::endl;
+    using namespace proto;
+    const std::string path = "/tmp/lob_replay_test_" + std::to_string(getpid()) + ".bin";
+
+    // Same flow applied live and recorded
+    OrderBook live;
+    cmdlog::Writer writer;
+    assert(writer.open(path));
+    uint8_t msg[64];
+    int64_t ts = 1000000;
+    auto send = [&](size_t) {
+        writer.append(ts, msg);
+        live.advance_time(std::chrono::nanoseconds(ts));
+        cmdlog::apply(live, msg);
+        ts += 500;
+    };
+    for (int i = 0; i < 2000; ++i) {
+        bool is_bid = i % 2 == 0;
+        double price = 100.0 + (is_bid ? -1.0 : 1.0) * (i % 7) * 0.25;
+        if (i % 50 == 49) send(encode_market(msg, is_bid, 30));
+        else if (i % 10 == 9) send(encode_cancel(msg, static_cast<uint64_t>(i - 5)));
+        else if (i % 10 == 8) send(encode_modify(msg, static_cast<uint64_t>(i - 3), price, 4));
+        else if (i % 10 == 7) send(encode_new_order(msg, is_bid, price - 3.0, 5, 1, ts + 2000));
+        else send(encode_new_order(msg, is_bid, price, 10 + i % 5, static_cast<uint32_t>(i % 3)));
+    }
+    assert(writer.close() && writer.records() == 2000);
+
+    cmdlog::MappedFile file;
+    assert(file.open(path));
+    cmdlog::Reader reader(file.data(), file.size());
+    assert(reader.valid() && reader.declared_records() == 2000);
+
+    OrderBook replayed;
+    cmdlog::ReplayStats stats = cmdlog::replay(replayed, file.data(), file.size());
+    assert(stats.commands == 2000 && !stats.truncated);
+    assert(stats.latency.count() == 2000);
+    assert(stats.latency.percentile(50) <= stats.latency.percentile(99));
+    assert(stats.latency.percentile(99) <= stats.latency.max());
+    assert(stats.recorded_span_ns == 1999 * 500);
+    assert(stats.trades == live.get_trades().size());
+    assert(replayed.total_orders() == live.total_orders());
+    LevelInfo a[16], b[16];
+    for (bool is_bid : {true, false}) {
+        size_t n = live.depth(is_bid, a, 16);
+        assert(replayed.depth(is_bid, b, 16) == n);
+        for (size_t i = 0; i < n; ++i) assert(a[i].price == b[i].price && a[i].qty == b[i].qty);
+    }
+
+    // Paced at 100x: the ~1 ms recorded span takes at least ~10 us
+    OrderBook paced;
+    cmdlog::ReplayOptions options;
+    options.paced = true;
+    options.speed = 100.0;
+    stats = cmdlog::replay(paced, file.data(), file.size(), options);
+    assert(stats.commands == 2000 && stats.lag.count() == 2000);
+    assert(stats.elapsed_ns >= 1999 * 500 / 100);
+
+    // Hardware counters: every command is charged to one kind, or the
+    // replay carries on and reports why the PMU is unavailable
+    OrderBook counted;
+    cmdlog::ReplayOptions counter_options;
+    counter_options.hardware_counters = true;
+    stats = cmdlog::replay(counted, file.data(), file.size(), counter_options);
+    assert(stats.commands == 2000 && stats.latency.count() == 2000);
+    assert(counted.total_orders() == live.total_orders());
+    if (stats.counters) {
+        assert(stats.add_counters.ops + stats.match_counters.ops + stats.cancel_counters.ops +
+               stats.modify_counters.ops == 2000);
+        assert(stats.cancel_counters.ops == 200 && stats.modify_counters.ops == 200);
+        assert(stats.match_counters.ops >= 40);  // every market order
+    } else {
+        assert(!stats.counters_error.empty());
+    }
+
+    // A cut-off tail is reported, complete records still replay
+    OrderBook cut;
+    stats = cmdlog::replay(cut, file.data(), file.size() - 3);
+    assert(stats.commands == 1999 && stats.truncated);
+    file.close();
+    std::remove(path.c_str());
+
+    LatencyHistogram h;
+    for (uint64_t v = 1; v <= 100000; ++v) h.record(v);
+    uint64_t p50 = h.percentile(50), p99 = h.percentile(99);
+    assert(p50 >= 50000 && p50 <= 50000 * 103 / 100);
+    assert(p99 >= 99000 && p99 <= 99000 * 103 / 100);
+    assert(h.min() == 1 && h.max() == 100000);
+
+    std::cout << "✓ Recorded flow replays to the same book, paced and truncated modes\n";
+}
+
+void test_text_import() {
+    std::cout << "\n=== Test: Text Log Import ===" << std::endl;
+    using namespace proto;
+    std::string text = "ts,type,a,b,c\n"
+                       "1000,N,B,99.5,10\r\n"
+                       "# comment\n"
+                       "\n"
+                       "1001,N,S,100.25,7,42,5000\n"
+                       "1002,M,1,99.75,8\n"
+                       "1003,Q,1\n"
+                       "1004,K,S,3\n"
+                       "1005,X,2\n"
+                       "1006,N,B,abc,5\n"
+                       "1007,N,B,nan,5\n"
+                       "1008,N,S,inf,5\n"
+                       "1009,M,1,-infinity,5\n"
+                       "1010,N,B,99.5,0\n"
+                       "1011,K,S,-3\n"
+                       "1012,M,1,99.5,0\n";
+    for (int i = 0; i < 500; ++i) text += std::to_string(2000 + i) + ",N,S," + std::to_string(101 + i % 5) + ".5,1\n";
+    text += "9999,X,3";  // no trailing newline
+
+    const std::string path = "/tmp/lob_import_test_" + std::to_string(getpid()) + ".bin";
+    std::vector<uint8_t> single;
+    for (unsigned threads : {1u, 4u}) {
+        cmdlog::Writer writer;
+        assert(writer.open(path));
+        textimport::ImportStats stats = textimport::convert(text.data(), text.size(), writer, threads);
+        assert(writer.close());
+        assert(stats.lines == 517 && stats.records == 506);
+        assert(stats.errors == 8 && stats.first_error_line == 7);
+
+        cmdlog::MappedFile file;
+        assert(file.open(path));
+        std::vector<uint8_t> bytes(file.data(), file.data() + file.size());
+        if (threads == 1) single = bytes;
+        else assert(bytes == single);  // chunks are merged back in input order
+
+        cmdlog::Reader reader(file.data(), file.size());
+        assert(reader.declared_records() == 506);
+        int64_t ts;
+        const uint8_t* msg;
+        assert(reader.next(ts, msg) && ts == 1000);
+        NewOrderView n1{msg};
+        assert(msg_type(msg) == MsgType::NewOrder && n1.is_bid() && n1.price() == 99.5 && n1.qty() == 10);
+        assert(reader.next(ts, msg) && ts == 1001);
+        NewOrderView n2{msg};
+        assert(!n2.is_bid() && n2.price() == 100.25 && n2.owner() == 42 && n2.expire_ns() == 5000);
+        assert(reader.next(ts, msg) && msg_type(msg) == MsgType::Modify && ModifyView{msg}.qty() == 8);
+        assert(reader.next(ts, msg) && msg_type(msg) == MsgType::Market && MarketView{msg}.qty() == 3);
+        assert(reader.next(ts, msg) && ts == 1005 && CancelView{msg}.order_id() == 2);
+        size_t rest = 0;
+        while (reader.next(ts, msg)) ++rest;
+        assert(rest == 501 && ts == 9999 && !reader.truncated());
+    }
+    std::remove(path.c_str());
+    std::cout << "✓ Text log converted in parallel chunks, order and errors preserved\n";
+}
+
+void test_order_flow_stress() {
+    std::cout << "\n=== Test: Synthetic Order Flow Stress ===" << std::endl;
+    FlowConfig cfg;
+    cfg.seed = 7;
+    cfg.burst_probability = 2e-5;
+    OrderFlowGenerator gen(cfg), same(cfg);
+    OrderBook ob;
+    const size_t n = 300000;
+    uint64_t limits = 0, cancels = 0, modifies = 0, markets = 0;
+    int64_t last_ts = -1;
+    for (size_t i = 0; i < n; ++i) {
+        const FlowEvent e = gen.next();
+        const FlowEvent& twin = same.next();
+        assert(twin.type == e.type && twin.order_id == e.order_id && twin.price == e.price &&
+               twin.qty == e.qty && twin.ts_ns == e.ts_ns);
+        assert(e.ts_ns >= last_ts);
+        last_ts = e.ts_ns;
+
+        // Every command is accepted and ids match the generator's prediction
+        uint64_t r = apply_flow(ob, e);
+        switch (e.type) {
+            case FlowEvent::Type::Limit: ++limits; assert(r == e.order_id); break;
+            case FlowEvent::Type::Market: ++markets; assert(r == e.order_id); break;
+            case FlowEvent::Type::Cancel: ++cancels; assert(r == 1); break;
+            case FlowEvent::Type::Modify: ++modifies; assert(r == 1); break;
+        }
+
+        if (i % 1000 == 0) {
+            LevelInfo bid, ask;
+            if (ob.depth(true, &bid, 1) && ob.depth(false, &ask, 1)) assert(bid.price < ask.price);
+        }
+    }
+
+    // The book tracks the generator's shadow and the mix looks like the config
+    assert(ob.total_orders() == gen.book().total_orders());
+    assert(ob.get_trades().size() == gen.trades());
+    const double ratio = static_cast<double>(cancels) / static_cast<double>(gen.trades());
+    assert(gen.sweeps() > 0 && markets > 0 && modifies > 0);
+    assert(ob.total_orders() > 2500 && ob.total_orders() < 10000);
+
+    // Deep book: many levels, sizes add up
+    static LevelInfo levels[100000];
+    size_t resting = 0, n_levels = 0;
+    for (bool is_bid : {true, false}) {
+        size_t k = ob.depth(is_bid, levels, 100000);
+        n_levels += k;
+        for (size_t i = 0; i < k; ++i) resting += levels[i].count;
+    }
+    assert(resting == ob.total_orders() && n_levels > 100);
+
+    std::cout << "✓ " << n << " events: " << limits << " limits, " << cancels << " cancels, "
+              << gen.trades() << " trades (" << ratio << ":1), " << gen.sweeps() << " sweeps, "
+              << n_levels << " levels\n";
+
+    // The cancel/trade ratio stays within 10% of the target: over 100k events
+    // without sweeps, and over 1M events with the default sweeps, whose fills
+    // take tens of thousands of events to work off
+    auto achieved = [](const FlowConfig& config, size_t events) {
+        OrderFlowGenerator flow(config);
+        for (size_t i = 0; i < events; ++i) flow.next();
+        return static_cast<double>(flow.cancels()) / static_cast<double>(flow.trades());
+    };
+    FlowConfig calm;
+    calm.burst_probability = 0.0;
+    const double calm_ratio = achieved(calm, 100000), long_ratio = achieved(FlowConfig{}, 1000000);
+    assert(std::abs(calm_ratio / calm.cancel_to_trade - 1.0) < 0.1);
+    assert(std::abs(long_ratio / FlowConfig{}.cancel_to_trade - 1.0) < 0.1);
+    std::cout << "✓ Cancel/trade ratio " << calm_ratio << ":1 without sweeps, " << long_ratio
+              << ":1 over 1M events with sweeps\n";
+}
+
+void test_perf_stats() {
+    std::cout << "\n=== Test: Perf-Check Statistics ===" << std::endl;
+    std::vector<double> base = {10, 11, 12, 13, 14, 15, 16, 17};
+    std::vector<double> same = {10.5, 11.5, 12.5, 13.5, 14.5, 15.5, 16.5};
+    std::vector<double> slower = {20, 21, 22, 23, 24, 25, 26, 27};
+
+    perf::MannWhitney mw = perf::mann_whitney(base, slower);
+    assert(mw.u == 64.0);            // every current sample beats every baseline one
+    assert(mw.p_greater < 0.001);
+    mw = perf::mann_whitney(slower, base);
+    assert(mw.u == 0.0 && mw.p_greater > 0.999);
+    mw = perf::mann_whitney(base, same);
+    assert(mw.p_greater > 0.2);
+    // All ties carry no evidence either way
+    assert(perf::mann_whitney({5, 5, 5}, {5, 5, 5}).p_greater == 1.0);
+    assert(perf::median({3, 1, 2}) == 2.0 && perf::median({4, 1, 3, 2}) == 2.5);
+
+    const std::string path = "/tmp/lob_perf_test_" + std::to_string(getpid()) + ".json";
+    perf::Results out{{"add", {1.5, 2.25}}, {"cancel", {3.0}}, {"empty", {}}};
+    perf::Results in;
+    perf::Drift drift_in;
+    assert(perf::write_json(path, out) && perf::read_json(path, in, &drift_in));
+    assert(in == out && drift_in.empty());
+    const perf::Drift drift_out{{"add", 4.25}, {"cancel", 0.5}};
+    assert(perf::write_json(path, out, drift_out) && perf::read_json(path, in, &drift_in));
+    assert(in == out && drift_in == drift_out);
+    assert(perf::read_json(path, in));  // drift is optional for the reader
+    std::remove(path.c_str());
+    assert(!perf::read_json(path, in));
+
+    // Drift: spread of block medians against the overall median
+    assert(perf::block_drift({10, 10, 10, 10, 10, 10, 10, 10}) == 0.0);
+    assert(std::abs(perf::block_drift({10, 10, 10, 10, 10, 10, 11, 11}) - 10.0) < 1e-9);
+    assert(perf::block_drift({10, 20, 30}) == 0.0);  // fewer samples than blocks
+
+    std::cout << "✓ Mann-Whitney U, medians, drift and JSON round trip\n";
+}
+
+void test_top_of_book() {
+    std::cout << "\n=== Test: Seqlock Top of Book ===" << std::endl;
+    OrderBook ob;
+    TopOfBook top;
+    ob.add_listener(&top);
+    Touch t;
+    BookDepth d;
+
+    assert(top.publish(ob) && top.version() == 1);
+    top.touch(t);
+    assert(t.bid_qty == 0 && t.ask_qty == 0 && t.version == 1);
+    assert(!top.publish(ob));  // nothing changed
+
+    for (int i = 0; i < 15; ++i) ob.add_limit(99.0 - i, 10 + i, true);
+    uint64_t far_ask = 0;
+    for (int i = 0; i < 15; ++i) far_ask = ob.add_limit(101.0 + i, 5, false);
+    assert(top.publish(ob));
+    top.touch(t);
+    assert(t.bid_price == 99.0 && t.bid_qty == 10 && t.ask_price == 101.0 && t.ask_qty == 5);
+    top.depth(d);
+    assert(d.bid_levels == BookDepth::DEPTH && d.ask_levels == BookDepth::DEPTH);
+    assert(d.bids[9].price == 90.0 && d.asks[9].price == 110.0 && d.version == t.version);
+
+    // Changes beyond the published levels do not publish
+    const uint64_t v = top.version();
+    ob.cancel(far_ask);                // 115, outside the top ten
+    ob.add_limit(80.0, 1, true);
+    assert(!top.publish(ob) && top.version() == v);
+    // ...changes at or inside them do
+    ob.add_limit(90.0, 1, true);       // the tenth bid level
+    assert(top.publish(ob));
+    ob.add_market(5, true);            // lifts 101
+    assert(top.publish(ob));
+    top.touch(t);
+    assert(t.ask_price == 102.0 && t.version == v + 2);
+    ob.clear();
+    top.invalidate();
+    assert(top.publish(ob));
+    top.touch(t);
+    assert(t.bid_qty == 0 && t.ask_qty == 0);
+
+    // Readers on other threads see only consistent records: every field of
+    // a published version was written together
+    SeqLock<BookDepth> lock;
+    std::atomic<bool> done{false};
+    std::atomic<uint64_t> torn{0}, reads{0};
+    std::vector<std::thread> readers;
+    for (int r = 0; r < 2; ++r) {
+        readers.emplace_back([&] {
+            BookDepth seen;
+            uint64_t last = 0;
+            while (!done.load(std::memory_order_acquire)) {
+                lock.load(seen);
+                const auto v = static_cast<int64_t>(seen.version);
+                bool ok = seen.bid_levels == seen.version % 7 && static_cast<uint64_t>(v) >= last;
+                for (size_t i = 0; i < BookDepth::DEPTH; ++i) {
+                    ok = ok && seen.bids[i].qty == v && seen.asks[i].qty == -v;
+                }
+                if (!ok) torn.fetch_add(1);
+                last = seen.version;
+                reads.fetch_add(1, std::memory_order_relaxed);
+            }
+        });
+    }
+    BookDepth w;
+    for (uint64_t version = 1; version <= 200000; ++version) {
+        w.version = version;
+        w.bid_levels = static_cast<uint32_t>(version % 7);
+        for (size_t i = 0; i < BookDepth::DEPTH; ++i) {
+            w.bids[i].qty = static_cast<int64_t>(version);
+            w.asks[i].qty = -static_cast<int64_t>(version);
+        }
+        lock.store(w);
+        if (version % 1000 == 0) std::this_thread::yield();  // let readers in on one core
+    }
+    done = true;
+    for (auto& th : readers) th.join();
+    assert(torn == 0 && reads > 0 && lock.version() == 200000);
+
+    std::cout << "✓ Touch and depth publish on top-level changes, concurrent reads are consistent\n";
+}
+
+void test_gateway() {
+    std::cout << "\n=== Test: Multi-Session Gateway ===" << std::endl;
+    using namespace proto;
+    uint8_t msg[NEW_ORDER_SIZE];
+
+    // Fair draining: a flooding session gets one quantum per pass
+    OrderGateway gw(3, 64);
+    encode_new_order(msg, true, 99.0, 1, 0);
+    for (int i = 0; i < 64; ++i) assert(gw.submit(0, msg));
+    assert(!gw.submit(0, msg));                     // ring full: back-pressure on session 0 only
+    encode_new_order(msg, false, 101.0, 1, 1);
+    assert(gw.submit(1, msg) && gw.submit(1, msg));
+    encode_ack(msg, MsgType::NewOrder, AckStatus::Accepted, 1);
+    assert(!gw.submit(2, msg));                     // outbound messages are refused
+
+    std::vector<size_t> order;
+    size_t got = gw.poll([&](size_t session, const uint8_t*) { order.push_back(session); }, 8);
+    assert(got == 10 && std::count(order.begin(), order.end(), 0) == 8);
+    assert(std::count(order.begin(), order.end(), 1) == 2);
+    assert(gw.stats(0).full == 1 && gw.stats(0).submitted == 64 && gw.stats(0).processed == 8);
+    OrderBook ob;
+    while (gw.drain(ob, 8)) {}
+    assert(gw.pending() == 0 && ob.total_orders() == 56);  // the first 8 bids were only inspected
+
+    // Concurrent sessions: every message arrives once, in session order
+    const size_t sessions = 4, per_session = 20000;
+    OrderGateway mt(sessions, 256);
+    std::vector<std::thread> producers;
+    for (size_t s = 0; s < sessions; ++s) {
+        producers.emplace_back([&mt, s] {
+            uint8_t m[NEW_ORDER_SIZE];
+            for (size_t i = 0; i < per_session; ++i) {
+                encode_new_order(m, true, 50.0, static_cast<int32_t>(i + 1), static_cast<uint32_t>(s));
+                while (!mt.submit(s, m)) std::this_thread::yield();
+            }
+        });
+    }
+    std::vector<int32_t> last(sessions, 0);
+    size_t received = 0;
+    bool in_order = true;
+    while (received < sessions * per_session) {
+        size_t n = mt.poll([&](size_t s, const uint8_t* m) {
+            NewOrderView v{m};
+            in_order = in_order && v.owner() == s && v.qty() == last[s] + 1;
+            last[s] = v.qty();
+        });
+        received += n;
+        if (n == 0) std::this_thread::yield();
+    }
+    for (auto& t : producers) t.join();
+    assert(in_order && mt.pending() == 0);
+    for (size_t s = 0; s < sessions; ++s) {
+        assert(mt.stats(s).submitted == per_session && mt.stats(s).processed == per_session);
+    }
+
+    std::cout << "✓ Round-robin quanta, per-session back-pressure, ordered concurrent intake\n";
+}
+
+void test_concurrent_book() {
+    std::cout << "\n=== Test: Concurrent Order Book ===" << std::endl;
+    // Single-threaded it matches exactly like OrderBook
+    ConcurrentOrderBook cb(50.0, 0.5, 200, 100000);
+    OrderBook ob;
+    uint64_t x = 12345;
+    auto rnd = [&x](uint64_t n) {
+        x = x * 6364136223846793005ull + 1442695040888963407ull;
+        return (x >> 33) % n;
+    };
+    std::vector<uint64_t> ids;
+    for (int i = 0; i < 20000; ++i) {
+        const uint64_t op = rnd(10);
+        const bool is_bid = rnd(2) == 0;
+        const int qty = 1 + static_cast<int>(rnd(20));
+        if (op < 6) {
+            const double price = 50.0 + 0.5 * static_cast<double>(88 + rnd(24));  // often crossing
+            const uint64_t a = cb.add_limit(price, qty, is_bid), b = ob.add_limit(price, qty, is_bid);
+            assert(a == b);
+            ids.push_back(a);
+        } else if (op < 9 && !ids.empty()) {
+            const uint64_t id = ids[rnd(ids.size())];
+            assert(cb.cancel(id) == ob.cancel(id));
+        } else {
+            assert(cb.add_market(qty, is_bid) == ob.add_market(qty, is_bid));
+        }
+    }
+    assert(cb.get_trades().size() == ob.get_trades().size() && cb.total_orders() == ob.total_orders());
+    for (size_t i = 0; i < ob.get_trades().size(); ++i) {
+        const Trade &a = cb.get_trades()[i], &b = ob.get_trades()[i];
+        assert(a.buyer_id == b.buyer_id && a.seller_id == b.seller_id && a.price == b.price && a.qty == b.qty);
+    }
+    LevelInfo la[64], lb[64];
+    for (bool is_bid : {true, false}) {
+        const size_t n = ob.depth(is_bid, lb, 64);
+        assert(cb.depth(is_bid, la, 64) == n);
+        for (size_t i = 0; i < n; ++i) {
+            assert(la[i].price == lb[i].price && la[i].qty == lb[i].qty && la[i].count == lb[i].count);
+        }
+    }
+    assert(cb.add_limit(50.25, 1, true) == 0 && cb.add_limit(200.0, 1, true) == 0);  // off the ladder
+
+    // Many threads: adds on both sides around a shared touch, cancels and
+    // crossing orders; the book must never rest crossed
+    ConcurrentOrderBook mt(90.0, 0.25, 80, 1 << 18);
+    std::atomic<uint64_t> limit_qty{0};
+    std::vector<std::thread> workers;
+    for (int w = 0; w < 4; ++w) {
+        workers.emplace_back([&, w] {
+            uint64_t y = 977 + static_cast<uint64_t>(w);
+            auto r = [&y](uint64_t n) {
+                y = y * 6364136223846793005ull + 1442695040888963407ull;
+                return (y >> 33) % n;
+            };
+            std::vector<uint64_t> mine;
+            for (int i = 0; i < 20000; ++i) {
+                const bool is_bid = r(2) == 0;
+                const uint64_t op = r(20);
+                if (op < 12) {
+                    // Mostly passive, sometimes through the middle of the ladder
+                    const int64_t tick = 40 + (is_bid ? -1 : 1) * (static_cast<int64_t>(r(30)) - 3);
+                    const uint64_t id = mt.add_limit(90.0 + 0.25 * static_cast<double>(tick), 5, is_bid);
+                    if (id) {
+                        mine.push_back(id);
+                        limit_qty.fetch_add(5);
+                    }
+                } else if (op < 19 && !mine.empty()) {
+                    const size_t k = r(mine.size());
+                    mt.cancel(mine[k]);
+                    mine[k] = mine.back();
+                    mine.pop_back();
+                } else {
+                    mt.add_market(3, is_bid);
+                }
+                if (i % 256 == 0) std::this_thread::yield();  // interleave on few cores
+            }
+        });
+    }
+    for (auto& t : workers) t.join();
+    LevelInfo bid, ask;
+    if (mt.depth(true, &bid, 1) && mt.depth(false, &ask, 1)) assert(bid.price < ask.price);
+    size_t counted = 0;
+    std::vector<LevelInfo> all(80);
+    for (bool is_bid : {true, false}) {
+        const size_t n = mt.depth(is_bid, all.data(), all.size());
+        for (size_t i = 0; i < n; ++i) counted += all[i].count;
+    }
+    assert(counted == mt.total_orders());
+    uint64_t traded = 0;
+    for (const auto& t : mt.get_trades()) {
+        assert(t.qty > 0 && t.buyer_id != t.seller_id);
+        traded += static_cast<uint64_t>(t.qty);
+    }
+    assert(traded <= limit_qty.load());
+    // Sweeping both sides empties the book
+    mt.add_market(1 << 30, true);
+    mt.add_market(1 << 30, false);
+    assert(mt.total_orders() == 0 && mt.depth(true, &bid, 1) == 0 && mt.depth(false, &ask, 1) == 0);
+
+    std::cout << "✓ Matches OrderBook single-threaded, never crosses under concurrent commands\n";
+}
+
+void test_trade_log() {
+    std::cout << "\n=== Test: Asynchronous Trade Log ===" << std::endl;
+    const std::string path = "/tmp/lob_trades_test_" + std::to_string(getpid()) + ".bin";
+    auto same = [](const std::vector<Trade>& a, const std::vector<Trade>& b) {
+        if (a.size() != b.size()) return false;
+        for (size_t i = 0; i < a.size(); ++i) {
+            if (a[i].buyer_id != b[i].buyer_id || a[i].seller_id != b[i].seller_id || a[i].price != b[i].price ||
+                a[i].qty != b[i].qty || a[i].ts != b[i].ts) {
+                return false;
+            }
+        }
+        return true;
+    };
+
+    // Every trade of a generated flow is persisted in order, through either
+    // journal backend, with and without a data sync per batch
+    for (int backend = 0; backend < 2; ++backend) {
+        for (bool sync : {false, true}) {
+            OrderBook ob;
+            tradelog::TradeLog log(backend == 0 ? journal::make_sync_backend() : journal::make_uring_backend());
+            tradelog::Options options;
+            options.sync = sync;
+            if (!log.open(path, options)) {
+                assert(backend == 1);
+                std::cout << "  io_uring unavailable here, skipped\n";
+                break;
+            }
+            ob.add_listener(&log);
+            OrderFlowGenerator gen;
+            for (int i = 0; i < (sync ? 20000 : 100000); ++i) apply_flow(ob, gen.next());
+            assert(log.close());
+            const tradelog::Stats st = log.stats();
+            assert(st.trades == ob.get_trades().size() && st.records_written == st.trades && !st.failed);
+            assert(st.write_calls >= (st.trades + options.batch_records - 1) / options.batch_records);
+            std::vector<Trade> back;
+            assert(tradelog::read_all(path, back) && same(back, ob.get_trades()));
+        }
+    }
+
+    // A tiny ring overflows into the backlog without losing or reordering
+    {
+        OrderBook ob;
+        tradelog::TradeLog log;
+        tradelog::Options options;
+        options.ring_capacity = 8;
+        options.batch_records = 4;
+        assert(log.open(path, options));
+        ob.add_listener(&log);
+        for (int i = 0; i < 5000; ++i) ob.add_limit(100.0, 1, false);
+        ob.add_market(5000, true);        // 5000 trades in one burst
+        const tradelog::Stats mid = log.stats();
+        assert(mid.ring_full > 0 && mid.backlog_peak > 0);
+        log.pump();
+        assert(log.close());
+        std::vector<Trade> back;
+        assert(tradelog::read_all(path, back) && same(back, ob.get_trades()));
+        assert(log.stats().records_written == 5000);
+    }
+    // A full batch that straddles the ring's wrap point goes out without
+    // waiting for max_delay
+    {
+        OrderBook ob;
+        tradelog::TradeLog log;
+        tradelog::Options options;
+        options.ring_capacity = 8;
+        options.batch_records = 6;
+        options.max_delay = std::chrono::seconds(30);
+        assert(log.open(path, options));
+        ob.add_listener(&log);
+        for (int i = 0; i < 12; ++i) ob.add_limit(100.0, 1, false);
+        auto written_within = [&](uint64_t n) {
+            const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+            while (log.stats().records_written < n && std::chrono::steady_clock::now() < deadline) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+            return log.stats().records_written == n;
+        };
+        ob.add_market(6, true);           // slots 0-5
+        assert(written_within(6));
+        ob.add_market(6, true);           // slots 6, 7, then 0-3
+        assert(written_within(12));
+        assert(log.stats().ring_full == 0 && log.close());
+    }
+    std::remove(path.c_str());
+    std::vector<Trade> none;
+    assert(!tradelog::read_all(path, none));
+
+    std::cout << "✓ Trades persisted in order off the matching thread, overflow kept in a backlog\n";
+}
+
+void test_journal() {
+    std::cout << "\n=== Test: Group-Commit Journal ===" << std::endl;
+    using namespace proto;
+    const std::string path = "/tmp/lob_journal_test_" + std::to_string(getpid()) + ".bin";
+    for (int backend = 0; backend < 2; ++backend) {
+        journal::Options options;
+        options.group_records = 16;
+        options.buffer_size = 4096;  // small: some groups are cut by a full buffer
+        journal::Journal j(backend == 0 ? journal::make_sync_backend() : journal::make_uring_backend(), options);
+        if (!j.open(path)) {
+            assert(backend == 1);
+            std::cout << "  io_uring unavailable here, skipped\n";
+            continue;
+        }
+        OrderBook live;
+        uint8_t msg[NEW_ORDER_SIZE];
+        for (int i = 0; i < 1000; ++i) {
+            const bool is_bid = i % 2 == 0;
+            if (i % 5 == 4) encode_cancel(msg, static_cast<uint64_t>(i - 2));
+            else encode_new_order(msg, is_bid, 100.0 + (is_bid ? -0.5 : 0.5) * (i % 3), 1 + i % 7, 0);
+            j.append(1000 + i, msg);
+            live.advance_time(std::chrono::nanoseconds(1000 + i));
+            cmdlog::apply(live, msg);
+        }
+        assert(j.appended() == 1000 && j.durable() <= j.appended());
+        assert(j.sync() && j.durable() == 1000);
+        assert(j.groups() >= 1000 / 16);
+        assert(j.close());
+
+        // The journal is a command log: replaying it rebuilds the same book
+        cmdlog::MappedFile file;
+        assert(file.open(path));
+        cmdlog::Reader reader(file.data(), file.size());
+        assert(reader.valid() && reader.declared_records() == 1000);
+        OrderBook replayed;
+        cmdlog::ReplayStats stats = cmdlog::replay(replayed, file.data(), file.size());
+        assert(stats.commands == 1000 && !stats.truncated);
+        assert(replayed.total_orders() == live.total_orders());
+        assert(replayed.get_trades().size() == live.get_trades().size());
+    }
+
+    // A buffer too small for one record is raised to fit the largest one
+    {
+        journal::Options options;
+        options.buffer_size = 1;
+        journal::Journal j(journal::make_sync_backend(), options);
+        assert(j.open(path));
+        uint8_t msg[NEW_ORDER_SIZE];
+        encode_new_order(msg, true, 100.0, 5, 0);
+        for (int i = 0; i < 3; ++i) j.append(i, msg);
+        assert(j.close() && j.groups() >= 3);
+        cmdlog::MappedFile file;
+        assert(file.open(path));
+        OrderBook replayed;
+        assert(cmdlog::replay(replayed, file.data(), file.size()).commands == 3 && replayed.total_orders() == 3);
+    }
+    std::remove(path.c_str());
+
+    std::cout << "✓ Both backends group-commit records into a replayable command log\n";
+}
+
+void test_deterministic_replication() {
+    std::cout << "\n=== Test: Deterministic Replication ===" << std::endl;
+    using namespace proto;
+    const std::string path = "/tmp/lob_replica_test_" + std::to_string(getpid()) + ".bin";
+    cmdlog::Writer writer;
+    assert(writer.open(path));
+    uint8_t msg[NEW_ORDER_SIZE];
+    for (int i = 0; i < 3000; ++i) {
+        const bool is_bid = i % 2 == 0;
+        const double price = 100.0 + (is_bid ? -0.25 : 0.25) * (i % 5);
+        if (i % 40 == 39) encode_market(msg, !is_bid, 25);
+        else if (i % 9 == 8) encode_cancel(msg, static_cast<uint64_t>(i - 6));
+        else if (i % 11 == 10) encode_modify(msg, static_cast<uint64_t>(i - 4), price, 3);
+        else encode_new_order(msg, is_bid, price, 5 + i % 9, 0);
+        writer.append(1000000 + 100 * static_cast<int64_t>(i), msg);
+    }
+    assert(writer.close());
+    cmdlog::MappedFile file;
+    assert(file.open(path));
+
+    // Primary and standby replay the same stream into identical books
+    cmdlog::ReplayOptions options;
+    options.per_command_latency = false;
+    options.checksum_interval = 100;
+    OrderBook primary, standby;
+    primary.set_deterministic(true);
+    standby.set_deterministic(true);
+    cmdlog::ReplayStats a = cmdlog::replay(primary, file.data(), file.size(), options);
+    cmdlog::ReplayStats b = cmdlog::replay(standby, file.data(), file.size(), options);
+    assert(a.checksums.size() == 30 && a.checksums == b.checksums);
+    assert(primary.checksum() == standby.checksum() && primary.checksum() != 0);
+    assert(a.trades > 0 && primary.get_trades().size() == standby.get_trades().size());
+    for (size_t i = 0; i < primary.get_trades().size(); ++i) {
+        const Trade& x = primary.get_trades()[i];
+        const Trade& y = standby.get_trades()[i];
+        assert(x.buyer_id == y.buyer_id && x.seller_id == y.seller_id && x.qty == y.qty);
+        // Stamped with the command's recorded time, not the wall clock
+        assert(x.ts == y.ts && x.ts.count() >= 1000000 && x.ts.count() < 1000000 + 100 * 3000);
+    }
+
+    // One altered quantity: checksums agree up to that command, then differ
+    std::vector<uint8_t> altered(file.data(), file.data() + file.size());
+    cmdlog::Reader reader(altered.data(), altered.size());
+    int64_t ts;
+    const uint8_t* m = nullptr;
+    for (int i = 0; i <= 1234; ++i) assert(reader.next(ts, m));
+    assert(msg_type(m) == MsgType::NewOrder);
+    uint8_t* qty = altered.data() + (m - altered.data()) + 12;
+    store<int32_t>(qty, load<int32_t>(qty) + 1);
+    OrderBook diverged;
+    diverged.set_deterministic(true);
+    cmdlog::ReplayStats c = cmdlog::replay(diverged, altered.data(), altered.size(), options);
+    for (size_t i = 0; i < 12; ++i) assert(c.checksums[i] == a.checksums[i]);
+    for (size_t i = 12; i < c.checksums.size(); ++i) assert(c.checksums[i] != a.checksums[i]);
+
+    primary.clear();
+    assert(primary.checksum() == 0);
+    file.close();
+    std::remove(path.c_str());
+
+    std::cout << "✓ Replicas agree on every checksum; a one-field change diverges from its command on\n";
+}
+
+template <class Book>
+void check_state_hash_flow(Book& book) {
+    // Deterministic mix of every path that changes a resting order
+    XorShift rnd{88172645463325252ULL};
+    std::vector<uint64_t> ids;
+    for (int i = 0; i < 4000; ++i) {
+        const bool is_bid = rnd(2) == 0;
+        const double price = 100.0 + (static_cast<double>(rnd(9)) - 4.0) * 0.5;
+        switch (rnd(10)) {
+            case 0: book.add_market(1 + static_cast<int>(rnd(40)), is_bid); break;
+            case 1: if (!ids.empty()) book.cancel(ids[rnd(ids.size())]); break;
+            case 2: if (!ids.empty()) book.modify(ids[rnd(ids.size())], price, 1 + static_cast<int>(rnd(20))); break;
+            case 3: book.cancel_all(static_cast<uint32_t>(rnd(4))); break;
+            case 4:
+                ids.push_back(book.add_limit(price, 1 + static_cast<int>(rnd(20)), is_bid,
+                                             std::chrono::nanoseconds(i + 1 + static_cast<int64_t>(rnd(50))),
+                                             static_cast<uint32_t>(rnd(4))));
+                break;
+            default:
+                ids.push_back(book.add_limit(price, 1 + static_cast<int>(rnd(20)), is_bid,
+                                             static_cast<uint32_t>(rnd(4))));
+                break;
+        }
+        book.advance_time(std::chrono::nanoseconds(i));
+        if (i % 500 == 250) book.begin_auction();
+        if (i % 500 == 300) book.uncross();
+        if (i == 3500) book.cancel_side(rnd(2) == 0);
+        assert(book.state_hash() == book.compute_state_hash());
+    }
+    assert(book.total_orders() > 0 && book.state_hash() != 0);
+}
+
+void test_state_hash() {
+    std::cout << "\n=== Test: Incremental State Hash ===" << std::endl;
+    OrderBook fifo;
+    ProRataOrderBook pro_rata;
+    TopOrderProRataOrderBook top_pro_rata;
+    check_state_hash_flow(fifo);
+    check_state_hash_flow(pro_rata);
+    check_state_hash_flow(top_pro_rata);
+
+    // Same resting orders by different paths: equal state hash, different
+    // checksum (which also covers the history)
+    OrderBook a, b;
+    a.add_limit(100.0, 10, true);
+    a.modify(1, 100.0, 4);
+    a.add_limit(101.0, 7, false);
+    b.add_limit(100.0, 4, true);
+    b.add_limit(101.0, 9, false);
+    b.add_limit(100.5, 2, true);
+    assert(a.state_hash() != b.state_hash());
+    b.add_market(2, true);  // 101.0 x 9 -> 7, and the bid at 100.5 (id 3) stays
+    b.cancel(3);
+    assert(a.state_hash() == b.state_hash() && a.checksum() != b.checksum());
+
+    fifo.clear();
+    assert(fifo.state_hash() == 0 && fifo.compute_state_hash() == 0);
+
+    std::cout << "✓ O(1) hash matches a full recompute after every add, fill, modify and cancel\n";
+}
+
+void test_trade_analytics() {
+    std::cout << "\n=== Test: Streaming Trade Analytics ===" << std::endl;
+    using std::chrono::nanoseconds;
+    OrderBook ob;
+    ob.set_deterministic(true);
+    ob.set_bar_interval(nanoseconds(1000));
+    ob.add_limit(101.0, 10, false);
+    ob.add_limit(102.0, 10, false);
+    ob.advance_time(nanoseconds(1500));
+    ob.add_limit(101.0, 4, true);    // 101 x 4
+    ob.advance_time(nanoseconds(1900));
+    ob.add_market(8, true);          // 101 x 6, 102 x 2
+    ob.advance_time(nanoseconds(4200));
+    ob.add_limit(99.0, 5, true);
+    ob.add_limit(99.0, 3, false);    // 99 x 3
+
+    const TradeAnalytics& a = ob.analytics();
+    assert(a.trades() == 4 && a.volume() == 15);
+    assert(std::abs(a.vwap() - (101.0 * 10 + 102.0 * 2 + 99.0 * 3) / 15) < 1e-9);
+    assert(a.last_price() == 99.0);
+    assert(a.bars().size() == 1);
+    const Bar& first = a.bars()[0];
+    assert(first.start == nanoseconds(1000) && first.trades == 3 && first.volume == 12);
+    assert(first.open == 101.0 && first.high == 102.0 && first.low == 101.0 && first.close == 102.0);
+    const Bar& open = a.current_bar();
+    assert(open.start == nanoseconds(4000) && open.trades == 1 && open.open == 99.0 && open.vwap() == 99.0);
+
+    // Without retention the history is never stored; analytics and replay
+    // trade counts are unchanged
+    OrderFlowGenerator gen;
+    OrderBook kept, streamed;
+    streamed.set_retain_trades(false);
+    for (int i = 0; i < 20000; ++i) {
+        const FlowEvent& e = gen.next();
+        apply_flow(kept, e);
+        apply_flow(streamed, e);
+    }
+    assert(streamed.get_trades().empty() && !kept.get_trades().empty());
+    assert(streamed.analytics().trades() == kept.get_trades().size());
+    double notional = 0.0;
+    int64_t volume = 0;
+    for (const Trade& t : kept.get_trades()) {
+        notional += t.price * t.qty;
+        volume += t.qty;
+    }
+    assert(streamed.analytics().volume() == volume);
+    assert(std::abs(streamed.analytics().vwap() - notional / static_cast<double>(volume)) < 1e-9);
+
+    ob.clear();
+    assert(ob.analytics().trades() == 0 && ob.analytics().bars().empty() && ob.analytics().vwap() == 0.0);
+
+    std::cout << "✓ VWAP, bars and counts match a rescan; history retention is optional\n";
+}
+
+// Signals recomputed from scratch through depth()
+void check_signals(const OrderBook& book, size_t n) {
+    LevelInfo levels[16];
+    const BookSignals s = book.signals();
+    for (bool is_bid : {true, false}) {
+        const size_t k = book.depth(is_bid, levels, n);
+        int64_t sum = 0;
+        for (size_t i = 0; i < k; ++i) sum += levels[i].qty;
+        assert((is_bid ? s.bid_depth : s.ask_depth) == sum);
+        assert((is_bid ? s.bid_qty : s.ask_qty) == (k ? levels[0].qty : 0));
+        assert((is_bid ? s.bid_price : s.ask_price) == (k ? levels[0].price : 0.0));
+    }
+}
+
+void test_book_signals() {
+    std::cout << "\n=== Test: Imbalance and Microprice Signals ===" << std::endl;
+    OrderBook ob;
+    ob.set_signal_depth(3);
+    assert(ob.signals().microprice() == 0.0 && ob.signals().imbalance() == 0.0);
+    ob.add_limit(99.0, 30, true);
+    ob.add_limit(98.0, 10, true);
+    ob.add_limit(101.0, 10, false);
+    BookSignals s = ob.signals();
+    assert(s.imbalance() == 0.5 && s.depth_imbalance() == 0.6);
+    assert(std::abs(s.microprice() - (99.0 * 10 + 101.0 * 30) / 40) < 1e-12);
+
+    // Random flow, including mass cancels and an auction, checked after every
+    // command against a rescan of the top levels
+    OrderBook flow;
+    flow.set_signal_depth(5);
+    XorShift rnd{2463534242ULL};
+    for (int i = 0; i < 20000; ++i) {
+        const bool is_bid = rnd(2) == 0;
+        const double price = 100.0 + (is_bid ? -1.0 : 1.0) * static_cast<double>(rnd(12)) * 0.25;
+        switch (rnd(12)) {
+            case 0: flow.add_market(1 + static_cast<int>(rnd(60)), is_bid); break;
+            case 1: case 2: flow.cancel(1 + rnd(static_cast<uint64_t>(i) + 1)); break;
+            case 3: flow.modify(1 + rnd(static_cast<uint64_t>(i) + 1), price, 1 + static_cast<int>(rnd(9))); break;
+            case 4: flow.add_limit(price - (is_bid ? -1.0 : 1.0), 1 + static_cast<int>(rnd(20)), is_bid); break;
+            default: flow.add_limit(price, 1 + static_cast<int>(rnd(20)), is_bid, static_cast<uint32_t>(rnd(8))); break;
+        }
+        if (i % 1000 == 999) flow.cancel_all(static_cast<uint32_t>(rnd(8)));
+        if (i == 15000) flow.cancel_side(true);
+        if (i == 17000) flow.begin_auction();
+        if (i == 17500) flow.uncross();
+        check_signals(flow, 5);
+    }
+    flow.clear();
+    check_signals(flow, 5);
+
+    // Mass cancels rebuild each band once and publish once, however many
+    // levels they empty
+    OrderBook wide;
+    wide.set_signal_depth(5);
+    for (int i = 0; i < 5000; ++i) {
+        wide.add_limit(50.0 - 0.01 * i, 1, true, static_cast<uint32_t>(i % 2));
+        wide.add_limit(150.0 + 0.01 * i, 1, false, 7);
+    }
+    uint64_t before = wide.signals().version;
+    assert(wide.cancel_all(0) == 2500);
+    assert(wide.signals().version == before + 1);
+    check_signals(wide, 5);
+    before = wide.signals().version;
+    assert(wide.cancel_side(false) == 5000);
+    assert(wide.signals().version == before + 1);
+    check_signals(wide, 5);
+
+    // A strategy thread reads while the book updates; every copy is consistent
+    OrderBook live;
+    live.set_signal_depth(5);
+    std::atomic<bool> done{false};
+    std::thread reader([&] {
+        uint64_t last = 0;
+        while (!done.load(std::memory_order_acquire)) {
+            const BookSignals r = live.signals();
+            assert(r.version >= last);
+            assert(r.bid_qty <= r.bid_depth && r.ask_qty <= r.ask_depth);
+            assert(r.imbalance() >= -1.0 && r.imbalance() <= 1.0);
+            last = r.version;
+        }
+    });
+    for (int i = 0; i < 200000; ++i) {
+        const bool is_bid = i % 2 == 0;
+        live.add_limit(100.0 + (is_bid ? -0.25 : 0.25) * (1 + i % 7), 1 + i % 13, is_bid);
+        if (i % 3 == 2) live.add_market(5, !is_bid);
+        if (i % 5 == 4) live.cancel(static_cast<uint64_t>(i - 2));
+    }
+    done.store(true, std::memory_order_release);
+    reader.join();
+    check_signals(live, 5);
+
+    std::cout << "✓ Incremental touch and depth aggregates match a rescan; readers never block\n";
+}
+
+void test_queue_position() {
+    std::cout << "\n=== Test: Queue Position ===" << std::endl;
+    OrderBook ob;
+    ob.add_limit(100.0, 10, true);   // id 1
+    ob.add_limit(100.0, 20, true);   // id 2
+    ob.add_limit(100.0, 30, true);   // id 3
+    QueuePosition p;
+    assert(ob.queue_position(3, p) && p.qty_ahead == 30 && p.orders_ahead == 2);
+    assert(ob.queue_position(1, p) && p.qty_ahead == 0 && p.orders_ahead == 0);
+    ob.add_market(5, false);         // fills 5 of id 1
+    assert(ob.queue_position(3, p) && p.qty_ahead == 25 && p.orders_ahead == 2);
+    ob.cancel(1);
+    assert(ob.queue_position(3, p) && p.qty_ahead == 20 && p.orders_ahead == 1);
+    ob.modify(2, 100.0, 5);          // reduce in place keeps priority
+    assert(ob.queue_position(3, p) && p.qty_ahead == 5 && p.orders_ahead == 1);
+    ob.modify(2, 100.0, 50);         // increase goes to the back
+    assert(ob.queue_position(3, p) && p.qty_ahead == 0 && p.orders_ahead == 0);
+    assert(ob.queue_position(2, p) && p.qty_ahead == 30 && p.orders_ahead == 1);
+    assert(!ob.queue_position(1, p) && !ob.queue_position(99, p));
+
+    // Churn on indexed levels (growing past the initial capacity) against a
+    // book rebuilt from the same commands, whose levels are indexed fresh
+    struct Cmd {
+        int kind;
+        bool is_bid;
+        double price;
+        int qty;
+        uint64_t id;
+    };
+    auto run = [](auto& book, const Cmd& c) {
+        switch (c.kind) {
+            case 0: book.add_market(c.qty, c.is_bid); break;
+            case 1: book.cancel(c.id); break;
+            case 2: book.modify(c.id, c.price, c.qty); break;
+            default: book.add_limit(c.price, c.qty, c.is_bid); break;
+        }
+    };
+    auto check = [&run](auto& live, const std::vector<Cmd>& history, uint64_t max_id, auto fresh) {
+        for (const Cmd& c : history) run(fresh, c);
+        size_t checked = 0;
+        for (uint64_t id = 1; id <= max_id; ++id) {
+            QueuePosition a, b;
+            const bool found = live.queue_position(id, a);
+            assert(found == fresh.queue_position(id, b));
+            if (found) {
+                assert(a.qty_ahead == b.qty_ahead && a.orders_ahead == b.orders_ahead);
+                ++checked;
+            }
+        }
+        return checked;
+    };
+    XorShift rnd{1181783497276652981ULL};
+    OrderBook fifo;
+    ProRataOrderBook pro_rata;
+    std::vector<Cmd> history;
+    size_t checked = 0;
+    for (int i = 1; i <= 6000; ++i) {
+        const bool is_bid = rnd(2) == 0;
+        Cmd c{3, is_bid, 100.0 + (is_bid ? -0.5 : 0.5) * static_cast<double>(rnd(3)), 1 + static_cast<int>(rnd(30)), 0};
+        switch (rnd(10)) {
+            case 0: c.kind = 0; c.qty = 1 + static_cast<int>(rnd(80)); break;
+            case 1: case 2: c.kind = 1; c.id = 1 + rnd(static_cast<uint64_t>(i)); break;
+            case 3: c.kind = 2; c.id = 1 + rnd(static_cast<uint64_t>(i)); break;
+            default: break;
+        }
+        history.push_back(c);
+        run(fifo, c);
+        run(pro_rata, c);
+        // Query a few orders so their levels stay indexed through the churn
+        QueuePosition p;
+        fifo.queue_position(1 + rnd(static_cast<uint64_t>(i)), p);
+        pro_rata.queue_position(1 + rnd(static_cast<uint64_t>(i)), p);
+        if (i % 1500 == 0) {
+            checked += check(fifo, history, static_cast<uint64_t>(i), OrderBook());
+            checked += check(pro_rata, history, static_cast<uint64_t>(i), ProRataOrderBook());
+        }
+    }
+    assert(checked > 1000);
+
+    std::cout << "✓ O(log n) queue position tracks fills, cancels and modifies (" << checked << " checks)\n";
+}
+
+int main() {
+    std::cout << "=====================================" << std::endl;
+    std::cout << "  Limit Order Book Advanced Tests" << std::endl;
+    std::cout << "=====================================" << std::endl;
+
+    try {
+        test_auction_uncross();
+        test_auction_no_cross();
+        test_auction_tiebreak();
+        test_auction_large();
+        test_pro_rata_allocation();
+        test_pro_rata_remainder();
+        test_top_order_pro_rata();
+        test_gtt_expiry();
+        test_gtt_many();
+        test_cancel_all_owner();
+        test_cancel_side();
+        test_disconnect_large();
+        test_soa_level();
+        test_order_index();
+        test_modify();
+        test_protocol_session();
+        test_md_feed();
+        test_command_log_replay();
+        test_text_import();
+        test_order_flow_stress();
+        test_perf_stats();
+        test_top_of_book();
+        test_gateway();
+        test_concurrent_book();
+        test_trade_log();
+        test_journal();
+        test_deterministic_replication();
+        test_state_hash();
+        test_trade_analytics();
+        test_book_signals();
+        test_queue_position();
+
+        std::cout << "\n=====================================" << std::endl;
+        std::cout << "  ✓ All advanced tests passed!" << std::endl;
+        std::cout << "=====================================" << std::endl;
+    } catch (const std::exception& e) {
+        std::cerr << "Test failed: " << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
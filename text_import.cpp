@@ -0,0 +1,209 @@
+#include "text_import.hpp"
+#include "protocol.hpp"
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <cstring>
+#include <thread>
+
+namespace textimport {
+
+namespace {
+
+// Input is converted in windows of this many bytes per worker, bounding
+// memory for multi-GB files while keeping every worker busy
+constexpr size_t WINDOW_PER_THREAD = 16 << 20;
+constexpr size_t MAX_RECORD = cmdlog::RECORD_HEADER_SIZE + proto::NEW_ORDER_SIZE;
+
+// Cursor over the comma-separated fields of one line
+struct Fields {
+    const char* p;
+    const char* end;
+    bool ok = true;
+
+    template <class T>
+    T number() {
+        T v{};
+        if (!ok || p >= end) {
+            ok = false;
+            return v;
+        }
+        auto r = std::from_chars(p, end, v);
+        if (r.ec != std::errc() || (r.ptr != end && *r.ptr != ',')) ok = false;
+        p = r.ptr + 1;
+        return v;
+    }
+
+    // from_chars also accepts "nan" and "inf", which the book rejects
+    double price() {
+        const double v = number<double>();
+        if (!std::isfinite(v)) ok = false;
+        return v;
+    }
+
+    // Text logs cancel with X, so a quantity must be positive
+    int32_t qty() {
+        const int32_t v = number<int32_t>();
+        if (v <= 0) ok = false;
+        return v;
+    }
+
+    char letter() {
+        if (!ok || p >= end || (p + 1 != end && p[1] != ',')) {
+            ok = false;
+            return 0;
+        }
+        char c = *p;
+        p += 2;
+        return c;
+    }
+
+    bool more() const { return ok && p < end; }
+    bool done() const { return ok && p >= end; }
+};
+
+bool side(char c, bool& is_bid) {
+    if (c == 'B' || c == 'b') is_bid = true;
+    else if (c == 'S' || c == 's') is_bid = false;
+    else return false;
+    return true;
+}
+
+// Encodes one line at out; returns bytes written, 0 if malformed
+size_t encode_line(const char* line, const char* end, uint8_t* out) {
+    Fields f{line, end};
+    const int64_t ts = f.number<int64_t>();
+    const char type = f.letter();
+    uint8_t* msg = out + cmdlog::RECORD_HEADER_SIZE;
+    size_t n = 0;
+    bool is_bid = false;
+    switch (type) {
+        case 'N': {
+            bool side_ok = side(f.letter(), is_bid);
+            double price = f.price();
+            int32_t qty = f.qty();
+            uint32_t owner = f.more() ? f.number<uint32_t>() : 0;
+            int64_t expire = f.more() ? f.number<int64_t>() : 0;
+            if (side_ok && f.done()) n = proto::encode_new_order(msg, is_bid, price, qty, owner, expire);
+            break;
+        }
+        case 'X': {
+            uint64_t id = f.number<uint64_t>();
+            if (f.done()) n = proto::encode_cancel(msg, id);
+            break;
+        }
+        case 'M': {
+            uint64_t id = f.number<uint64_t>();
+            double price = f.price();
+            int32_t qty = f.qty();
+            if (f.done()) n = proto::encode_modify(msg, id, price, qty);
+            break;
+        }
+        case 'K': {
+            bool side_ok = side(f.letter(), is_bid);
+            int32_t qty = f.qty();
+            if (side_ok && f.done()) n = proto::encode_market(msg, is_bid, qty);
+            break;
+        }
+        default:
+            break;
+    }
+    if (n == 0) return 0;
+    proto::store<int64_t>(out, ts);
+    return cmdlog::RECORD_HEADER_SIZE + n;
+}
+
+}  // namespace
+
+void ImportStats::merge(const ImportStats& chunk) {
+    if (chunk.errors && !errors) first_error_line = lines + chunk.first_error_line;
+    lines += chunk.lines;
+    records += chunk.records;
+    errors += chunk.errors;
+    bytes += chunk.bytes;
+}
+
+ImportStats parse_chunk(const char* begin, const char* end, std::vector<uint8_t>& out, bool file_start) {
+    ImportStats stats;
+    stats.bytes = static_cast<size_t>(end - begin);
+    size_t pos = out.size();
+    // Worst case a record is 40 bytes for a ~10-character line
+    out.resize(pos + (stats.bytes / 10 + 1) * MAX_RECORD);
+
+    for (const char* line = begin; line < end;) {
+        const char* nl = static_cast<const char*>(std::memchr(line, '\n', static_cast<size_t>(end - line)));
+        const char* eol = nl ? nl : end;
+        const char* next = nl ? nl + 1 : end;
+        if (eol > line && eol[-1] == '\r') --eol;
+        ++stats.lines;
+
+        if (eol == line || *line == '#') {
+            line = next;
+            continue;
+        }
+        size_t n = encode_line(line, eol, out.data() + pos);
+        if (n) {
+            pos += n;
+            ++stats.records;
+        } else if (!(file_start && stats.lines == 1 && (*line < '0' || *line > '9'))) {
+            // A non-numeric first line of the file is a column header
+            if (!stats.errors) stats.first_error_line = stats.lines;
+            ++stats.errors;
+        }
+        line = next;
+    }
+    out.resize(pos);
+    return stats;
+}
+
+ImportStats convert(const char* text, size_t len, cmdlog::Writer& writer, unsigned threads) {
+    if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+    ImportStats total;
+    std::vector<std::vector<uint8_t>> outs(threads);
+    std::vector<ImportStats> parts(threads);
+    std::vector<std::thread> workers;
+
+    size_t window_start = 0;
+    while (window_start < len) {
+        // Split the window into one chunk per worker, each ending on a newline
+        const size_t window_end = std::min(len, window_start + WINDOW_PER_THREAD * threads);
+        std::vector<size_t> cuts{window_start};
+        for (unsigned t = 1; t <= threads; ++t) {
+            size_t cut = t == threads ? window_end
+                                      : window_start + (window_end - window_start) * t / threads;
+            cut = std::max(cut, cuts.back());
+            if (cut < len) {
+                const void* nl = std::memchr(text + cut, '\n', len - cut);
+                cut = nl ? static_cast<size_t>(static_cast<const char*>(nl) - text) + 1 : len;
+            }
+            cuts.push_back(cut);
+        }
+
+        workers.clear();
+        for (unsigned t = 0; t < threads; ++t) {
+            outs[t].clear();
+            workers.emplace_back([&, t] {
+                parts[t] = parse_chunk(text + cuts[t], text + cuts[t + 1], outs[t], cuts[t] == 0);
+            });
+        }
+        for (auto& w : workers) w.join();
+
+        for (unsigned t = 0; t < threads; ++t) {
+            total.merge(parts[t]);
+            writer.append_records(outs[t].data(), outs[t].size(), parts[t].records);
+        }
+        window_start = cuts.back();
+    }
+    return total;
+}
+
+bool convert_file(const std::string& in_path, const std::string& out_path,
+                  ImportStats& stats, unsigned threads) {
+    cmdlog::MappedFile in;
+    cmdlog::Writer writer;
+    if (!in.open(in_path) || !writer.open(out_path)) return false;
+    stats = convert(reinterpret_cast<const char*>(in.data()), in.size(), writer, threads);
+    return writer.close();
+}
+
+}  // namespace textimport
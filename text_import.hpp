@@ -0,0 +1,46 @@
+#pragma once
+#include "command_log.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Converts text order logs into the binary command log (command_log.hpp).
+//
+// One command per line, comma separated, timestamp in nanoseconds first:
+//
+//   ts,N,side,price,qty[,owner[,expire_ns]]   new limit order (side B or S)
+//   ts,X,order_id                             cancel
+//   ts,M,order_id,price,qty                   modify
+//   ts,K,side,qty                             market order
+//
+// Blank lines, lines starting with '#' and a leading header line are skipped.
+// Numbers are parsed with std::from_chars; the input is split at line
+// boundaries into chunks that are converted in parallel and written back in
+// input order.
+namespace textimport {
+
+struct ImportStats {
+    uint64_t lines = 0;
+    uint64_t records = 0;
+    uint64_t errors = 0;           // malformed lines, skipped
+    uint64_t first_error_line = 0; // 1-based, 0 if none
+    size_t bytes = 0;
+
+    void merge(const ImportStats& chunk);
+};
+
+// Encodes every line in [begin, end) (whole lines only) as records appended
+// to out; error line numbers are relative to the chunk. Only a chunk at the
+// start of the file may begin with a header line.
+ImportStats parse_chunk(const char* begin, const char* end, std::vector<uint8_t>& out,
+                        bool file_start = true);
+
+// Converts an in-memory text log using up to `threads` workers
+ImportStats convert(const char* text, size_t len, cmdlog::Writer& writer, unsigned threads = 0);
+
+// Maps in_path and writes the command log to out_path; false on I/O errors
+bool convert_file(const std::string& in_path, const std::string& out_path,
+                  ImportStats& stats, unsigned threads = 0);
+
+}  // namespace textimport
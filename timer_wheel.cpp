@@ -0,0 +1,96 @@
+#include "timer_wheel.hpp"
+
+namespace {
+constexpr uint64_t level_range(int level) { return 1ull << (TimerWheel::SLOT_BITS * (level + 1)); }
+constexpr uint64_t slot_range(int level) { return 1ull << (TimerWheel::SLOT_BITS * level); }
+// Past this distance an entry parks in the top-level slot just behind "now"
+constexpr uint64_t MAX_SPAN = level_range(TimerWheel::LEVELS - 1) - slot_range(TimerWheel::LEVELS - 1);
+}
+
+TimerWheel::TimerWheel(std::chrono::nanoseconds res) : resolution(res.count() > 0 ? res : std::chrono::nanoseconds(1)) {}
+
+void TimerWheel::schedule(uint64_t id, std::chrono::nanoseconds deadline) {
+    int64_t ns = deadline.count() < 0 ? 0 : deadline.count();
+    int64_t res = resolution.count();
+    uint64_t tick = static_cast<uint64_t>(ns / res + (ns % res != 0));
+    if (tick <= now_tick) {
+        ready.push_back(id);
+        return;
+    }
+    place({id, tick});
+    ++count;
+}
+
+void TimerWheel::place(const Entry& e) {
+    int level, slot;
+    if (e.deadline - now_tick >= MAX_SPAN) {
+        level = LEVELS - 1;
+        slot = static_cast<int>(((now_tick >> (SLOT_BITS * level)) + SLOTS - 1) & (SLOTS - 1));
+    } else {
+        uint64_t masked = (now_tick ^ e.deadline) | (SLOTS - 1);
+        level = (63 - __builtin_clzll(masked)) / SLOT_BITS;
+        if (level >= LEVELS) level = LEVELS - 1;  // wraps into the next top-level rotation
+        slot = static_cast<int>((e.deadline >> (SLOT_BITS * level)) & (SLOTS - 1));
+    }
+    slots[level][slot].push_back(e);
+    occupied[level] |= 1ull << slot;
+}
+
+bool TimerWheel::next_slot(int level, int& slot, uint64_t& deadline) const {
+    uint64_t occ = occupied[level];
+    if (occ == 0) return false;
+    int now_slot = static_cast<int>((now_tick >> (SLOT_BITS * level)) & (SLOTS - 1));
+    uint64_t rotated = now_slot ? (occ >> now_slot) | (occ << (SLOTS - now_slot)) : occ;
+    slot = (now_slot + __builtin_ctzll(rotated)) & (SLOTS - 1);
+    deadline = (now_tick & ~(level_range(level) - 1)) + slot * slot_range(level);
+    if (slot < now_slot) deadline += level_range(level);
+    return true;
+}
+
+void TimerWheel::advance(std::chrono::nanoseconds now, std::vector<uint64_t>& expired) {
+    expired.insert(expired.end(), ready.begin(), ready.end());
+    ready.clear();
+
+    int64_t ns = now.count() < 0 ? 0 : now.count();
+    uint64_t target = static_cast<uint64_t>(ns / resolution.count());
+    if (target < now_tick) return;
+
+    while (count > 0) {
+        // Earliest occupied slot across all levels; lower level wins ties
+        int best_level = -1, best_slot = 0;
+        uint64_t best_deadline = 0;
+        for (int level = 0; level < LEVELS; ++level) {
+            int slot;
+            uint64_t deadline;
+            if (next_slot(level, slot, deadline) && (best_level < 0 || deadline < best_deadline)) {
+                best_level = level;
+                best_slot = slot;
+                best_deadline = deadline;
+            }
+        }
+        if (best_deadline > target) break;
+
+        now_tick = best_deadline;
+        scratch.swap(slots[best_level][best_slot]);
+        occupied[best_level] &= ~(1ull << best_slot);
+        for (const Entry& e : scratch) {
+            if (e.deadline <= now_tick) {
+                expired.push_back(e.id);
+                --count;
+            } else {
+                place(e);  // cascade to a finer level
+            }
+        }
+        scratch.clear();
+    }
+    now_tick = target;
+}
+
+void TimerWheel::clear() {
+    for (auto& level : slots)
+        for (auto& slot : level) slot.clear();
+    for (auto& occ : occupied) occ = 0;
+    ready.clear();
+    now_tick = 0;
+    count = 0;
+}
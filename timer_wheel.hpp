@@ -0,0 +1,47 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+// Hierarchical timing wheel for order expiry.
+//
+// LEVELS wheels of 64 slots; a slot at level L spans 64^L ticks. Entries are
+// placed by the highest 6-bit group in which their deadline differs from the
+// current tick, and cascade one level down each time their slot comes due.
+// A per-level occupancy bitmap lets advance() jump straight to the next
+// non-empty slot, so the cost is proportional to the entries that fire (plus
+// at most LEVELS cascades each), not to elapsed time or to resting orders.
+class TimerWheel {
+public:
+    static constexpr int LEVELS = 6;
+    static constexpr int SLOT_BITS = 6;
+    static constexpr int SLOTS = 1 << SLOT_BITS;
+
+    explicit TimerWheel(std::chrono::nanoseconds resolution = std::chrono::microseconds(1));
+
+    // Deadlines are rounded up to the next tick, so entries never fire early
+    void schedule(uint64_t id, std::chrono::nanoseconds deadline);
+    // Appends ids whose deadline is <= now to expired (in no particular order)
+    void advance(std::chrono::nanoseconds now, std::vector<uint64_t>& expired);
+
+    std::chrono::nanoseconds now() const { return resolution * static_cast<int64_t>(now_tick); }
+    size_t size() const { return count + ready.size(); }
+    void clear();
+
+private:
+    struct Entry {
+        uint64_t id;
+        uint64_t deadline;  // in ticks
+    };
+
+    std::vector<Entry> slots[LEVELS][SLOTS];
+    uint64_t occupied[LEVELS] = {};
+    std::vector<Entry> scratch;
+    std::vector<uint64_t> ready;  // scheduled at or before the current tick
+    std::chrono::nanoseconds resolution;
+    uint64_t now_tick = 0;
+    size_t count = 0;
+
+    void place(const Entry& e);
+    bool next_slot(int level, int& slot, uint64_t& deadline) const;
+};
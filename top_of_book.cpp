@@ -0,0 +1,31 @@
+#include "top_of_book.hpp"
+
+void TopOfBook::on_level(bool is_bid, const LevelInfo& level) {
+    if (dirty) return;
+    // A change can only reach the published top levels if the side had
+    // fewer than DEPTH of them or the price is at or inside the worst one
+    const uint32_t n = is_bid ? current.bid_levels : current.ask_levels;
+    if (n < BookDepth::DEPTH) {
+        dirty = true;
+        return;
+    }
+    const double worst = is_bid ? current.bids[n - 1].price : current.asks[n - 1].price;
+    dirty = is_bid ? level.price >= worst : level.price <= worst;
+}
+
+void TopOfBook::commit() {
+    dirty = false;
+    current.version = depth_lock.version() + 1;
+    Touch t;
+    t.version = current.version;
+    if (current.bid_levels) {
+        t.bid_price = current.bids[0].price;
+        t.bid_qty = current.bids[0].qty;
+    }
+    if (current.ask_levels) {
+        t.ask_price = current.asks[0].price;
+        t.ask_qty = current.asks[0].qty;
+    }
+    touch_lock.store(t);
+    depth_lock.store(current);
+}
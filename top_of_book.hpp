@@ -0,0 +1,64 @@
+#pragma once
+#include "book_events.hpp"
+#include "seqlock.hpp"
+#include <cstddef>
+#include <cstdint>
+
+// Best bid and offer; price and qty are 0 on an empty side
+struct Touch {
+    double bid_price = 0.0, ask_price = 0.0;
+    int64_t bid_qty = 0, ask_qty = 0;
+    uint64_t version = 0;  // publish count when this copy was written
+};
+
+// Top DEPTH levels of each side, best first
+struct BookDepth {
+    static constexpr size_t DEPTH = 10;
+    uint32_t bid_levels = 0, ask_levels = 0;
+    LevelInfo bids[DEPTH];
+    LevelInfo asks[DEPTH];
+    uint64_t version = 0;
+};
+
+// Shares the touch and top-N depth of a book with other threads.
+//
+// Attach it as a BookListener and call publish() on the matching thread
+// after each command. on_level() marks the record dirty only when a change
+// can reach the published levels, so publish() costs a flag test after most
+// commands away from the touch. Readers on any thread call touch() or
+// depth(); they never block the matching thread.
+class TopOfBook : public BookListener {
+public:
+    void on_level(bool is_bid, const LevelInfo& level) override;
+
+    // Matching thread: refreshes both records if the top levels changed.
+    // Returns true if a new version was published.
+    template <class Book>
+    bool publish(const Book& book);
+    // Forces the next publish(), e.g. after clear(), which is not reported
+    void invalidate() { dirty = true; }
+
+    // Any thread
+    void touch(Touch& out) const { touch_lock.load(out); }
+    void depth(BookDepth& out) const { depth_lock.load(out); }
+    uint64_t version() const { return depth_lock.version(); }
+
+private:
+    // Writer-side state, never read by other threads
+    BookDepth current;
+    bool dirty = true;
+
+    SeqLock<Touch> touch_lock;
+    SeqLock<BookDepth> depth_lock;
+
+    void commit();
+};
+
+template <class Book>
+bool TopOfBook::publish(const Book& book) {
+    if (!dirty) return false;
+    current.bid_levels = static_cast<uint32_t>(book.depth(true, current.bids, BookDepth::DEPTH));
+    current.ask_levels = static_cast<uint32_t>(book.depth(false, current.asks, BookDepth::DEPTH));
+    commit();
+    return true;
+}
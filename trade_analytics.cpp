@@ -0,0 +1,38 @@
+#include "trade_analytics.hpp"
+#include <algorithm>
+
+void TradeAnalytics::record(double price, int qty, std::chrono::nanoseconds ts) {
+    ++total_trades;
+    total_volume += qty;
+    total_notional += price * qty;
+    last = price;
+
+    const int64_t len = bar_interval.count();
+    const std::chrono::nanoseconds start{len > 0 ? ts.count() - ts.count() % len : open_bar.start.count()};
+    // A trade stamped before the open bar (the wall clock stepped back) joins it
+    if (open_bar.trades == 0 || start > open_bar.start) {
+        if (open_bar.trades != 0) closed.push_back(open_bar);
+        open_bar = Bar{start, price, price, price, price, 0, 0, 0.0};
+    }
+    open_bar.high = std::max(open_bar.high, price);
+    open_bar.low = std::min(open_bar.low, price);
+    open_bar.close = price;
+    open_bar.volume += qty;
+    ++open_bar.trades;
+    open_bar.notional += price * qty;
+}
+
+void TradeAnalytics::set_interval(std::chrono::nanoseconds interval) {
+    if (open_bar.trades != 0) closed.push_back(open_bar);
+    open_bar = Bar{};
+    bar_interval = interval;
+}
+
+void TradeAnalytics::clear() {
+    total_trades = 0;
+    total_volume = 0;
+    total_notional = 0.0;
+    last = 0.0;
+    open_bar = Bar{};
+    closed.clear();
+}
@@ -0,0 +1,51 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+// OHLCV for one bar interval. Intervals without trades produce no bar.
+struct Bar {
+    std::chrono::nanoseconds start{0};  // a multiple of the bar interval
+    double open = 0.0, high = 0.0, low = 0.0, close = 0.0;
+    int64_t volume = 0;
+    uint64_t trades = 0;
+    double notional = 0.0;              // sum of price * qty
+
+    double vwap() const { return volume ? notional / static_cast<double>(volume) : 0.0; }
+};
+
+// Running trade statistics, folded in O(1) per trade as the book matches,
+// so consumers query them without rescanning the trade history
+class TradeAnalytics {
+public:
+    explicit TradeAnalytics(std::chrono::nanoseconds interval = std::chrono::seconds(1))
+        : bar_interval(interval) {}
+
+    void record(double price, int qty, std::chrono::nanoseconds ts);
+    // Closes the open bar; later trades fall into bars of the new length.
+    // A non-positive interval keeps every trade in the open bar.
+    void set_interval(std::chrono::nanoseconds interval);
+    std::chrono::nanoseconds interval() const { return bar_interval; }
+    void clear();
+
+    // Since construction or clear()
+    uint64_t trades() const { return total_trades; }
+    int64_t volume() const { return total_volume; }
+    double notional() const { return total_notional; }
+    double vwap() const { return total_volume ? total_notional / static_cast<double>(total_volume) : 0.0; }
+    double last_price() const { return last; }
+
+    // Closed bars, oldest first
+    const std::vector<Bar>& bars() const { return closed; }
+    // The bar trades are currently added to; trades == 0 before the first
+    const Bar& current_bar() const { return open_bar; }
+
+private:
+    std::chrono::nanoseconds bar_interval;
+    uint64_t total_trades = 0;
+    int64_t total_volume = 0;
+    double total_notional = 0.0;
+    double last = 0.0;
+    Bar open_bar;
+    std::vector<Bar> closed;
+};
@@ -0,0 +1,208 @@
+#include "trade_log.hpp"
+#include "command_log.hpp"
+#include <algorithm>
+#include <cstring>
+
+namespace tradelog {
+
+using proto::load;
+using proto::store;
+using Clock = std::chrono::steady_clock;
+
+namespace {
+
+void raise_peak(std::atomic<uint64_t>& peak, uint64_t v) {
+    if (v > peak.load(std::memory_order_relaxed)) peak.store(v, std::memory_order_relaxed);
+}
+
+void add(std::atomic<uint64_t>& counter, uint64_t v) {
+    counter.store(counter.load(std::memory_order_relaxed) + v, std::memory_order_relaxed);
+}
+
+// Writes the header from buffer 0; close() patches in the record count
+bool write_header(journal::Backend& backend, uint64_t count) {
+    uint8_t* header = backend.buffer(0);
+    std::memcpy(header, MAGIC, sizeof(MAGIC));
+    store<uint64_t>(header + 8, count);
+    return backend.submit(0, FILE_HEADER_SIZE, 0) && backend.wait();
+}
+
+}  // namespace
+
+void encode_record(Record& r, const Trade& trade) {
+    store<int64_t>(r.bytes, trade.ts.count());
+    proto::encode_fill(r.bytes + 8, trade);
+}
+
+TradeLog::TradeLog(std::unique_ptr<journal::Backend> b) : backend(std::move(b)) {}
+
+TradeLog::~TradeLog() { close(); }
+
+bool TradeLog::open(const std::string& path, const Options& options) {
+    close();
+    const size_t batch = std::max<size_t>(options.batch_records, 1);
+    if (!backend->open(path, std::max(batch * RECORD_SIZE, FILE_HEADER_SIZE), options.sync)) return false;
+    if (!write_header(*backend, 0)) {
+        backend->close();
+        return false;
+    }
+    opts = options;
+    opts.batch_records = batch;
+    ring = std::make_unique<SpscRing<Record>>(options.ring_capacity);
+    backlog.clear();
+    backlog_head = 0;
+    stopping.store(false);
+    failed.store(false);
+    for (auto* c : {&trades, &ring_full, &backlog_peak, &ring_peak, &records_written, &write_calls}) c->store(0);
+    opened = true;
+    writer = std::thread([this] { run_writer(); });
+    return true;
+}
+
+bool TradeLog::close() {
+    if (!opened) return true;
+    // Hand over the backlog; only here may the matching thread wait
+    while (!drain_backlog()) std::this_thread::yield();
+    stopping.store(true, std::memory_order_release);
+    writer.join();
+
+    // The writer has reaped every batch, so both buffers are free
+    bool ok = !failed.load();
+    if (!write_header(*backend, records_written.load())) ok = false;
+    backend->close();
+    opened = false;
+    ring.reset();
+    return ok;
+}
+
+// True once the backlog is empty
+bool TradeLog::drain_backlog() {
+    while (backlog_head < backlog.size()) {
+        Record* slot = ring->claim();
+        if (!slot) return false;
+        *slot = backlog[backlog_head++];
+        ring->publish();
+    }
+    backlog.clear();
+    backlog_head = 0;
+    return true;
+}
+
+void TradeLog::on_trade(const Trade& trade) {
+    if (!opened) return;
+    add(trades, 1);
+    // Keep order: nothing may overtake an older trade still in the backlog
+    if (backlog_head == backlog.size() || drain_backlog()) {
+        if (Record* slot = ring->claim()) {
+            encode_record(*slot, trade);
+            ring->publish();
+            return;
+        }
+    }
+    add(ring_full, 1);
+    backlog.emplace_back();
+    encode_record(backlog.back(), trade);
+    raise_peak(backlog_peak, backlog.size() - backlog_head);
+}
+
+void TradeLog::pump() {
+    if (opened) drain_backlog();
+}
+
+void TradeLog::run_writer() {
+    Clock::time_point waiting_since{};
+    bool waiting = false;
+    int active = 0;                       // staging buffer being filled
+    uint64_t offset = FILE_HEADER_SIZE;   // where the next batch goes
+    uint64_t in_flight = 0;               // records submitted, not yet reaped
+    // One batch in flight at a time, as in journal::Journal::commit()
+    auto reap = [&] {
+        if (in_flight == 0) return;
+        if (backend->wait()) add(records_written, in_flight);
+        else failed.store(true);
+        in_flight = 0;
+    };
+    for (;;) {
+        const bool stop = stopping.load(std::memory_order_acquire);
+        // size() rather than peek(): a batch may straddle the ring's wrap point
+        const size_t queued = ring->size();
+        if (queued == 0) {
+            if (stop) break;
+            waiting = false;
+            reap();
+            std::this_thread::sleep_for(std::chrono::microseconds(50));
+            continue;
+        }
+        // Let a batch build up unless the oldest record has waited long enough
+        if (queued < opts.batch_records && !stop) {
+            const auto now = Clock::now();
+            if (!waiting) {
+                waiting = true;
+                waiting_since = now;
+            }
+            if (now - waiting_since < opts.max_delay) {
+                std::this_thread::sleep_for(std::chrono::microseconds(50));
+                continue;
+            }
+        }
+        waiting = false;
+        raise_peak(ring_peak, queued);
+        // Copy up to a batch, in two runs when it wraps. The active buffer
+        // was reaped before the other one was submitted.
+        const bool writing = !failed.load(std::memory_order_relaxed);
+        uint8_t* buf = backend->buffer(active);
+        size_t n = 0;
+        const Record* first = nullptr;
+        while (n < opts.batch_records) {
+            const size_t run = std::min(ring->peek(first), opts.batch_records - n);
+            if (run == 0) break;
+            if (writing) std::memcpy(buf + n * RECORD_SIZE, first->bytes, run * RECORD_SIZE);
+            ring->release(run);
+            n += run;
+        }
+        if (!writing) continue;
+        const size_t bytes = n * RECORD_SIZE;
+        reap();
+        if (!failed.load(std::memory_order_relaxed) && backend->submit(active, bytes, offset)) {
+            in_flight = n;
+            add(write_calls, 1);
+        } else {
+            failed.store(true);
+        }
+        offset += bytes;
+        active ^= 1;
+    }
+    reap();
+}
+
+Stats TradeLog::stats() const {
+    Stats s;
+    s.trades = trades.load(std::memory_order_relaxed);
+    s.ring_full = ring_full.load(std::memory_order_relaxed);
+    s.backlog_peak = backlog_peak.load(std::memory_order_relaxed);
+    s.ring_peak = ring_peak.load(std::memory_order_relaxed);
+    s.records_written = records_written.load(std::memory_order_relaxed);
+    s.write_calls = write_calls.load(std::memory_order_relaxed);
+    s.failed = failed.load(std::memory_order_relaxed);
+    return s;
+}
+
+bool read_all(const std::string& path, std::vector<Trade>& out) {
+    cmdlog::MappedFile file;
+    if (!file.open(path)) return false;
+    const uint8_t* p = file.data();
+    const size_t len = file.size();
+    if (len < FILE_HEADER_SIZE || std::memcmp(p, MAGIC, sizeof(MAGIC)) != 0) return false;
+    const uint64_t declared = load<uint64_t>(p + 8);
+    if ((len - FILE_HEADER_SIZE) % RECORD_SIZE != 0 || (len - FILE_HEADER_SIZE) / RECORD_SIZE != declared) return false;
+    out.clear();
+    out.reserve(declared);
+    for (size_t pos = FILE_HEADER_SIZE; pos < len; pos += RECORD_SIZE) {
+        proto::FillView f{p + pos + 8};
+        out.emplace_back(f.buyer_id(), f.seller_id(), f.price(), f.qty());
+        out.back().ts = std::chrono::nanoseconds(load<int64_t>(p + pos));
+    }
+    return true;
+}
+
+}  // namespace tradelog
@@ -0,0 +1,104 @@
+#pragma once
+#include "book_events.hpp"
+#include "journal.hpp"
+#include "orderbook.hpp"
+#include "protocol.hpp"
+#include "spsc_ring.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Trade log written off the matching thread.
+//
+// The file has the command log's layout: a 16-byte header (8-byte magic,
+// uint64 record count patched on close) and 40-byte records of an int64
+// nanosecond timestamp followed by a Fill message from protocol.hpp.
+namespace tradelog {
+
+constexpr char MAGIC[8] = {'L', 'O', 'B', 'T', 'R', 'D', '0', '1'};
+constexpr size_t FILE_HEADER_SIZE = 16;
+constexpr size_t RECORD_SIZE = 8 + proto::FILL_SIZE;
+
+struct Record {
+    alignas(8) uint8_t bytes[RECORD_SIZE];
+};
+
+struct Options {
+    size_t ring_capacity = 1 << 16;               // records
+    size_t batch_records = 1024;                  // records per write, at most
+    std::chrono::microseconds max_delay{1000};    // ...unless the oldest waited this long
+    bool sync = false;                            // fdatasync after every write
+};
+
+struct Stats {
+    uint64_t trades = 0;          // handed over by the matching thread
+    uint64_t ring_full = 0;       // trades that found the ring full and went to the backlog
+    uint64_t backlog_peak = 0;    // largest matching-thread backlog
+    uint64_t ring_peak = 0;       // most records the writer found queued at once
+    uint64_t records_written = 0;
+    uint64_t write_calls = 0;
+    bool failed = false;          // a write or sync failed; later records are dropped
+};
+
+// Attach as a BookListener. on_trade() encodes each trade straight into a
+// preallocated ring slot. A writer thread copies runs of slots into the
+// backend's two staging buffers and submits them as large sequential writes,
+// so with io_uring one batch is written while the next is collected.
+//
+// The matching thread never waits. When the ring is full, trades go to a
+// backlog owned by the matching thread. Later trades and pump() move the
+// backlog into the ring as space frees up.
+class TradeLog : public BookListener {
+public:
+    // The backend's data sync follows Options::sync
+    explicit TradeLog(std::unique_ptr<journal::Backend> backend = journal::make_sync_backend());
+    ~TradeLog() override;
+    TradeLog(const TradeLog&) = delete;
+    TradeLog& operator=(const TradeLog&) = delete;
+
+    // Creates the file and starts the writer thread
+    bool open(const std::string& path, const Options& options = {});
+    // Matching thread: hands over the backlog, waits until every record is
+    // written and patches the header. False if any write failed.
+    bool close();
+    bool is_open() const { return opened; }
+    const char* backend_name() const { return backend->name(); }
+
+    void on_trade(const Trade& trade) override;
+    // Matching thread: moves backlog into the ring; call when idle
+    void pump();
+
+    // Any thread; counters are read without locks
+    Stats stats() const;
+
+private:
+    std::unique_ptr<journal::Backend> backend;
+    bool opened = false;
+    Options opts;
+    std::unique_ptr<SpscRing<Record>> ring;
+    std::thread writer;
+    std::atomic<bool> stopping{false};
+
+    // Matching thread
+    std::vector<Record> backlog;
+    size_t backlog_head = 0;
+    std::atomic<uint64_t> trades{0}, ring_full{0}, backlog_peak{0};
+
+    // Writer thread
+    std::atomic<uint64_t> ring_peak{0}, records_written{0}, write_calls{0};
+    std::atomic<bool> failed{false};
+
+    bool drain_backlog();
+    void run_writer();
+};
+
+void encode_record(Record& r, const Trade& trade);
+// Reads a whole trade log; false if the file is missing or malformed
+bool read_all(const std::string& path, std::vector<Trade>& out);
+
+}  // namespace tradelog